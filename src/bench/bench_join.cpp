@@ -0,0 +1,128 @@
+/*
+ * bench_join.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ *
+ * Compares merge join of cross pairs with the original lockstep loop
+ * on dense and sparse series. Series are kept in memory, each key decode
+ * and each seek is counted, because these are the expensive operations of
+ * a real database iterator.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "../main/merge_join.h"
+
+using Series = std::vector<std::pair<std::uint64_t, double> >;
+
+struct Counters {
+	std::size_t decodes = 0;
+	std::size_t seeks = 0;
+};
+
+struct MockKey {
+	std::uint64_t t;
+	std::uint64_t getUInt() const {return t;}
+};
+struct MockValue {
+	double v;
+	double getNumber() const {return v;}
+};
+
+class MockIterator {
+public:
+	MockIterator(const Series &s, std::uint64_t from, Counters &cnt)
+		:s(s),cnt(cnt) {
+		cnt.seeks++;
+		pos = std::lower_bound(s.begin(), s.end(), std::pair<std::uint64_t,double>(from, 0)) - s.begin();
+	}
+	bool next() {
+		if (first) first = false; else ++pos;
+		return pos < s.size();
+	}
+	MockKey key(unsigned int) const {cnt.decodes++;return {s[pos].first};}
+	MockValue value() const {return {s[pos].second};}
+protected:
+	const Series &s;
+	Counters &cnt;
+	std::size_t pos;
+	bool first = true;
+};
+
+///original loop from iterateData
+template<typename Fn>
+static void legacyJoin(const Series &a, const Series &b, Counters &cnt, Fn &&out) {
+	MockIterator iter1(a, 0, cnt);
+	MockIterator iter2(b, 0, cnt);
+	bool rep_iter1 = false;
+	bool rep_iter2 = false;
+	while ((rep_iter1 || iter1.next()) && (rep_iter2 || iter2.next())) {
+		rep_iter1 = false;
+		rep_iter2 = false;
+		auto t1 = iter1.key(1).getUInt();
+		auto t2 = iter2.key(1).getUInt();
+		if (t1 < t2) rep_iter2 = true;
+		else if (t1 > t2) rep_iter1 = true;
+		else {
+			double v1 = iter1.value().getNumber();
+			double v2 = iter2.value().getNumber();
+			out(t1, v1/v2);
+		}
+	}
+}
+
+///Generates minute series. Every gapEvery days, the series has gap gapDays long
+static Series generate(std::uint64_t days, std::uint64_t gapEvery, std::uint64_t gapDays, std::mt19937 &rnd) {
+	Series s;
+	double p = 100;
+	std::normal_distribution<double> step(0, 0.001);
+	for (std::uint64_t d = 0; d < days; d++) {
+		if (gapEvery && (d % gapEvery) < gapDays) continue;
+		for (std::uint64_t m = 0; m < 1440; m++) {
+			p *= 1.0 + step(rnd);
+			s.push_back({(d*1440+m)*60, p});
+		}
+	}
+	return s;
+}
+
+static void run(const char *name, const Series &a, const Series &b) {
+	Counters c1, c2;
+	std::size_t n1 = 0, n2 = 0;
+	double sum1 = 0, sum2 = 0;
+
+	auto st1 = std::chrono::steady_clock::now();
+	legacyJoin(a, b, c1, [&](std::uint64_t, double v){n1++;sum1+=v;});
+	auto st2 = std::chrono::steady_clock::now();
+	mergeJoin(0, [&](std::uint64_t f){return MockIterator(a, f, c2);},
+				 [&](std::uint64_t f){return MockIterator(b, f, c2);}, false,
+				 [&](std::uint64_t, double v1, double v2){n2++;sum2+=v1/v2;});
+	auto st3 = std::chrono::steady_clock::now();
+
+	auto ms = [](auto d){return std::chrono::duration_cast<std::chrono::microseconds>(d).count()*0.001;};
+	std::printf("%-16s legacy: %9.3f ms %10zu decodes %6zu seeks | merge: %9.3f ms %10zu decodes %6zu seeks | points %zu%s\n",
+			name, ms(st2-st1), c1.decodes, c1.seeks, ms(st3-st2), c2.decodes, c2.seeks, n2,
+			(n1 == n2 && sum1 == sum2)?"":" MISMATCH");
+}
+
+int main(int, char **) {
+	std::mt19937 rnd(1);
+	Series dense1 = generate(365, 0, 0, rnd);
+	Series dense2 = generate(365, 0, 0, rnd);
+	Series sparse1 = generate(365, 10, 9, rnd);
+	Series sparse2 = generate(365, 7, 5, rnd);
+	Series late = generate(365, 365, 300, rnd);
+
+	run("dense/dense", dense1, dense2);
+	run("sparse/dense", sparse1, dense2);
+	run("dense/sparse", dense1, sparse2);
+	run("sparse/sparse", sparse1, sparse2);
+	run("late/dense", late, dense1);
+	return 0;
+}
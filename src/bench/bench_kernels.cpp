@@ -0,0 +1,362 @@
+/*
+ * bench_kernels.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ *
+ * Benchmark of the vector kernels on long ranges. Every kernel is measured at all
+ * levels supported by the CPU and compared with the per-item loop used before
+ * (one value at a time, as it arrives from the iterator).
+ *
+ * The end-to-end part compares iterateData and iterateCandles (one price at a time)
+ * with the same work staged to runs of 512 prices for the kernels, over in-memory
+ * series. Decoding of the database is not included, bench_micro measures it on a real
+ * database.
+ *
+ *   bench_kernels [-n count] [-r repeats]
+ *
+ *   -n count of minute prices (default 4194304, ~8 years)
+ *   -r repeats of every measurement, best time is reported (default 5)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+#include "../main/iterate_data.h"
+#include "kernels.h"
+
+using Series = std::vector<std::pair<std::uint64_t, double> >;
+
+struct MockKey {
+	std::uint64_t t;
+	std::uint64_t getUInt() const {return t;}
+};
+struct MockValue {
+	double v;
+	double getNumber() const {return v;}
+};
+
+class MockIterator {
+public:
+	MockIterator(const Series &s, std::uint64_t from, std::uint64_t to)
+		:s(s),to(to) {
+		pos = std::lower_bound(s.begin(), s.end(), std::pair<std::uint64_t,double>(from, 0)) - s.begin();
+	}
+	bool next() {
+		if (first) first = false; else ++pos;
+		return pos < s.size() && s[pos].first < to;
+	}
+	MockKey key(unsigned int) const {return {s[pos].first};}
+	MockValue value() const {return {s[pos].second};}
+protected:
+	const Series &s;
+	std::uint64_t to;
+	std::size_t pos;
+	bool first = true;
+};
+
+///Series of symbols in memory, same interface as the price store
+class MockSource {
+public:
+	struct Key {
+		std::string_view symbol;
+		std::uint64_t t;
+	};
+	MockIterator range(const Key &from, const Key &to) const {
+		return MockIterator(series.at(std::string(from.symbol)), from.t, to.t);
+	}
+	std::map<std::string, Series> series;
+};
+
+///Run of prices collected for the vector kernels
+struct PriceRun {
+	static constexpr std::size_t capacity = 512;
+	std::uint64_t times[capacity];
+	double v1[capacity];
+	double v2[capacity];
+	std::size_t size = 0;
+};
+
+///Prices of a pair staged to runs, inverses and ratios computed by the kernels
+template<typename Fn>
+static void stagedRuns(const MockSource &src, std::string_view asset, std::string_view currency, Fn &&out) {
+	std::uint64_t to = -1;
+	PriceRun run;
+	std::size_t n = 0;
+	if (asset == "usd" || currency == "usd") {
+		bool inverse = asset == "usd";
+		std::string_view symbol = inverse?currency:asset;
+		auto flush = [&] {
+			if (inverse) kernels::inverse(run.v1, run.v1, n);
+			run.size = n;
+			out(run);
+			n = 0;
+		};
+		auto iter1 = src.range({symbol, 0},{symbol, to});
+		while (iter1.next()) {
+			run.times[n] = itemTime(iter1);
+			run.v1[n] = itemPrice(iter1);
+			if (++n == PriceRun::capacity) flush();
+		}
+		if (n) flush();
+	} else {
+		auto flush = [&] {
+			kernels::divide(run.v1, run.v2, run.v1, n);
+			run.size = n;
+			out(run);
+			n = 0;
+		};
+		mergeJoin(0, [&](std::uint64_t f){
+			return src.range({asset, f},{asset, to});
+		}, [&](std::uint64_t f){
+			return src.range({currency, f},{currency, to});
+		}, false, [&](std::uint64_t t, double v1, double v2){
+			run.times[n] = t;
+			run.v1[n] = v1;
+			run.v2[n] = v2;
+			if (++n == PriceRun::capacity) flush();
+		});
+		if (n) flush();
+	}
+}
+
+template<typename Fn>
+static void stagedIterate(const MockSource &src, std::string_view asset, std::string_view currency, Fn &&out) {
+	stagedRuns(src, asset, currency, [&](const PriceRun &run) {
+		for (std::size_t i = 0; i < run.size; i++) out(run.times[i], run.v1[i]);
+	});
+}
+
+///candles folded by iterateCandles (one price at a time)
+static std::size_t itemCandles(const MockSource &src, std::string_view asset, std::string_view currency, std::uint64_t tfrm, std::vector<Candle> &candles) {
+	candles.clear();
+	iterateCandles(src, asset, currency, 0, 0, tfrm, false, [&](const Candle &cd) {
+		candles.push_back(cd);
+	});
+	return candles.size();
+}
+
+///candles folded by the kernels over runs, candles split by runs are merged
+static std::size_t stagedCandles(const MockSource &src, std::string_view asset, std::string_view currency, std::uint64_t tfrm, std::vector<Candle> &candles) {
+	Candle buff[PriceRun::capacity];
+	candles.clear();
+	stagedRuns(src, asset, currency, [&](const PriceRun &run) {
+		std::size_t cnt = kernels::foldOHLC(run.times, run.v1, run.size, tfrm, buff);
+		for (std::size_t i = 0; i < cnt; i++) {
+			const Candle &cd = buff[i];
+			if (candles.empty() || candles.back().t != cd.t) {
+				candles.push_back(cd);
+			} else {
+				Candle &last = candles.back();
+				last.h = std::max(last.h, cd.h);
+				last.l = std::min(last.l, cd.l);
+				last.c = cd.c;
+			}
+		}
+	});
+	return candles.size();
+}
+
+static std::string cpuName() {
+	std::ifstream f("/proc/cpuinfo");
+	std::string line;
+	while (std::getline(f, line)) {
+		if (line.compare(0, 10, "model name") == 0) {
+			auto p = line.find(':');
+			if (p != line.npos) return line.substr(p+2);
+		}
+	}
+	return "unknown CPU";
+}
+
+template<typename Fn>
+static double measure(unsigned int repeats, Fn &&fn) {
+	double best = 1e99;
+	for (unsigned int r = 0; r < repeats; r++) {
+		auto start = std::chrono::steady_clock::now();
+		fn();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+static void report(const char *name, const char *level, std::size_t n, double secs, double baseline) {
+	std::printf("%-18s %-8s %10.3f ms %10.1f Mitems/s %8.2fx\n", name, level, secs*1000, n/secs/1e6, baseline/secs);
+}
+
+//keeps results alive
+static volatile double sink;
+
+int main(int argc, char **argv) {
+	std::size_t n = 1 << 22;
+	unsigned int repeats = 5;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+		switch (opt) {
+		case 'n': n = std::strtoull(optarg, nullptr, 10);break;
+		case 'r': repeats = std::max(1UL, std::strtoul(optarg, nullptr, 10));break;
+		default: std::fprintf(stderr, "Usage: %s [-n count] [-r repeats]\n", argv[0]); return 1;
+		}
+	}
+
+	std::mt19937_64 rnd(1);
+	std::normal_distribution<double> norm(0.0, 1.0);
+	std::vector<std::uint64_t> times(n);
+	std::vector<double> a(n), b(n), out(n);
+	std::vector<Candle> candles(n);
+	double pa = 20000, pb = 1500;
+	std::uint64_t t = 1600000000/60*60;
+	for (std::size_t i = 0; i < n; i++) {
+		//few missing minutes
+		t += (norm(rnd) > 2.5)?120:60;
+		times[i] = t;
+		a[i] = pa *= std::exp(norm(rnd)*0.001);
+		b[i] = pb *= std::exp(norm(rnd)*0.0015);
+	}
+
+	//per-item loops, as they were interleaved with the iterator
+	double baseDiv = measure(repeats, [&]{
+		for (std::size_t i = 0; i < n; i++) out[i] = a[i]/b[i];
+		sink = out[n/2];
+	});
+	double baseInv = measure(repeats, [&]{
+		for (std::size_t i = 0; i < n; i++) out[i] = 1.0/a[i];
+		sink = out[n/2];
+	});
+	auto foldItems = [&](std::uint64_t tfrm) {
+		std::size_t cnt = 0;
+		std::uint64_t lastFrame = 0;
+		for (std::size_t i = 0; i < n; i++) {
+			std::uint64_t f = times[i]/tfrm;
+			double v = a[i];
+			if (f != lastFrame || cnt == 0) {
+				candles[cnt++] = {f*tfrm, v, v, v, v};
+				lastFrame = f;
+			} else {
+				Candle &c = candles[cnt-1];
+				c.h = std::max(c.h, v);
+				c.l = std::min(c.l, v);
+				c.c = v;
+			}
+		}
+		return cnt;
+	};
+	const std::uint64_t timeframes[] = {300, 3600, 86400};
+	double baseFold[3];
+	std::size_t expected[3];
+	for (int k = 0; k < 3; k++) {
+		baseFold[k] = measure(repeats, [&]{expected[k] = foldItems(timeframes[k]);});
+	}
+	std::vector<Candle> reference(candles.begin(), candles.begin() + expected[2]);
+
+	std::printf("%s, %zu prices, best of %u runs\n", cpuName().c_str(), n, repeats);
+	report("divide", "per-item", n, baseDiv, baseDiv);
+	report("inverse", "per-item", n, baseInv, baseInv);
+	for (int k = 0; k < 3; k++) {
+		char name[32];
+		std::snprintf(name, sizeof(name), "fold %lus", static_cast<unsigned long>(timeframes[k]));
+		report(name, "per-item", n, baseFold[k], baseFold[k]);
+	}
+
+	for (auto lv: {kernels::Level::scalar, kernels::Level::sse2, kernels::Level::avx2}) {
+		if (kernels::setLevel(lv) != lv) continue;
+		const char *name = kernels::levelName(lv);
+		report("divide", name, n, measure(repeats, [&]{
+			kernels::divide(a.data(), b.data(), out.data(), n);
+			sink = out[n/2];
+		}), baseDiv);
+		report("inverse", name, n, measure(repeats, [&]{
+			kernels::inverse(a.data(), out.data(), n);
+			sink = out[n/2];
+		}), baseInv);
+		for (int k = 0; k < 3; k++) {
+			std::size_t cnt = 0;
+			char title[32];
+			std::snprintf(title, sizeof(title), "fold %lus", static_cast<unsigned long>(timeframes[k]));
+			report(title, name, n, measure(repeats, [&]{
+				cnt = kernels::foldOHLC(times.data(), a.data(), n, timeframes[k], candles.data());
+			}), baseFold[k]);
+			if (cnt != expected[k]) {
+				std::fprintf(stderr, "%s: count of candles differs (%zu != %zu)\n", title, cnt, expected[k]);
+				return 1;
+			}
+		}
+		for (std::size_t i = 0; i < reference.size(); i++) {
+			const Candle &x = candles[i], &y = reference[i];
+			if (x.t != y.t || x.o != y.o || x.h != y.h || x.l != y.l || x.c != y.c) {
+				std::fprintf(stderr, "%s: candle %zu differs\n", name, i);
+				return 1;
+			}
+		}
+	}
+
+	//end-to-end over the iterator
+	MockSource src;
+	{
+		Series &sa = src.series["btc"];
+		Series &sb = src.series["eth"];
+		sa.reserve(n);
+		sb.reserve(n);
+		for (std::size_t i = 0; i < n; i++) {
+			sa.emplace_back(times[i], a[i]);
+			sb.emplace_back(times[i], b[i]);
+		}
+	}
+	double sum = 0;
+	auto collect = [&](std::uint64_t, double v) {sum += v;};
+	struct Pair {
+		const char *name;
+		std::string_view asset;
+		std::string_view currency;
+	};
+	const Pair pairs[] = {{"e2e direct", "btc", "usd"}, {"e2e inverse", "usd", "btc"}, {"e2e cross", "btc", "eth"}};
+	double basePair[3];
+	for (int k = 0; k < 3; k++) {
+		basePair[k] = measure(repeats, [&]{iterateData(src, pairs[k].asset, pairs[k].currency, 0, 0, 1, false, collect);});
+	}
+	std::vector<Candle> items, folded;
+	double baseCandles[3];
+	for (int k = 0; k < 3; k++) {
+		baseCandles[k] = measure(repeats, [&]{itemCandles(src, "btc", "eth", timeframes[k], items);});
+	}
+	for (int k = 0; k < 3; k++) report(pairs[k].name, "per-item", n, basePair[k], basePair[k]);
+	for (int k = 0; k < 3; k++) {
+		char title[32];
+		std::snprintf(title, sizeof(title), "e2e ohlc %lus", static_cast<unsigned long>(timeframes[k]));
+		report(title, "per-item", n, baseCandles[k], baseCandles[k]);
+	}
+	for (auto lv: {kernels::Level::scalar, kernels::Level::sse2, kernels::Level::avx2}) {
+		if (kernels::setLevel(lv) != lv) continue;
+		const char *name = kernels::levelName(lv);
+		for (int k = 0; k < 3; k++) {
+			report(pairs[k].name, name, n, measure(repeats, [&]{
+				stagedIterate(src, pairs[k].asset, pairs[k].currency, collect);
+			}), basePair[k]);
+		}
+		for (int k = 0; k < 3; k++) {
+			char title[32];
+			std::snprintf(title, sizeof(title), "e2e ohlc %lus", static_cast<unsigned long>(timeframes[k]));
+			report(title, name, n, measure(repeats, [&]{stagedCandles(src, "btc", "eth", timeframes[k], folded);}), baseCandles[k]);
+			itemCandles(src, "btc", "eth", timeframes[k], items);
+			bool same = items.size() == folded.size() && std::equal(items.begin(), items.end(), folded.begin(), [](const Candle &x, const Candle &y){
+				return x.t == y.t && x.o == y.o && x.h == y.h && x.l == y.l && x.c == y.c;
+			});
+			if (!same) {
+				std::fprintf(stderr, "%s %s: candles differ\n", title, name);
+				return 1;
+			}
+		}
+	}
+	sink = sum;
+	return 0;
+}
@@ -0,0 +1,379 @@
+/*
+ * bench_load.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ *
+ * HTTP load driver. Replays a mix of /minute, /daily, /ohlc, /history and /collector
+ * requests against a running instance over keep-alive connections and reports
+ * throughput and latency percentiles of each endpoint.
+ *
+ *   bench_load [-a address] [-p port] [-c connections] [-t seconds] [-m mix] [-r seed]
+ *
+ *   -a address of the server (default 127.0.0.1)
+ *   -p port (default 3456)
+ *   -c count of connections, each has own thread (default 8)
+ *   -t duration in seconds (default 10)
+ *   -m weights of the endpoints (default minute=40,daily=15,ohlc=25,history=15,collector=5)
+ *   -r random seed (default 1)
+ *
+ * Symbols and their ranges are read from /symbols. Collector requests post prices
+ * to /collector/binance without a commit, so the database is not modified.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../main/json_reader.h"
+#include "../main/metrics.h"
+
+enum Endpoint {minute, daily, ohlc, history, collector, endpointCount};
+static const char *endpointNames[] = {"minute","daily","ohlc","history","collector"};
+
+struct SymbolInfo {
+	std::string name;
+	std::uint64_t firstDay;
+	std::uint64_t lastDay;
+};
+
+struct EndpointStats {
+	Histogram latency;
+	Counter requests;
+	Counter errors;
+	Counter bytes;
+};
+
+///Simple HTTP/1.1 client connection with keep-alive
+class Connection {
+public:
+	Connection(const sockaddr_in &addr):addr(addr) {}
+	~Connection() {close();}
+
+	///Sends request and reads response
+	/**
+	 * @return status code, 0 on connection error
+	 */
+	int request(const std::string &req, std::size_t &bodySize);
+
+protected:
+	sockaddr_in addr;
+	int fd = -1;
+	std::string buffer;
+
+	bool connect();
+	void close() {if (fd >= 0) ::close(fd); fd = -1; buffer.clear();}
+	bool readMore();
+	bool readLine(std::string &line);
+	bool readBytes(std::size_t count);
+};
+
+bool Connection::connect() {
+	fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return false;
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool Connection::readMore() {
+	char buff[65536];
+	ssize_t r = ::recv(fd, buff, sizeof(buff), 0);
+	if (r <= 0) return false;
+	buffer.append(buff, r);
+	return true;
+}
+
+bool Connection::readLine(std::string &line) {
+	std::size_t pos;
+	while ((pos = buffer.find("\r\n")) == buffer.npos) {
+		if (!readMore()) return false;
+	}
+	line = buffer.substr(0, pos);
+	buffer.erase(0, pos+2);
+	return true;
+}
+
+bool Connection::readBytes(std::size_t count) {
+	while (buffer.size() < count) {
+		if (!readMore()) return false;
+	}
+	buffer.erase(0, count);
+	return true;
+}
+
+int Connection::request(const std::string &req, std::size_t &bodySize) {
+	bodySize = 0;
+	for (int attempt = 0; attempt < 2; attempt++) {
+		if (fd < 0 && !connect()) return 0;
+		if (::send(fd, req.data(), req.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(req.size())) {
+			close();
+			continue;
+		}
+		std::string line;
+		if (!readLine(line)) {
+			//keep-alive connection closed by the server, retry on new connection
+			close();
+			continue;
+		}
+		int status = 0;
+		auto sp = line.find(' ');
+		if (sp != line.npos) status = std::atoi(line.c_str() + sp + 1);
+		long contentLength = -1;
+		bool chunked = false;
+		bool keepAlive = true;
+		while (readLine(line) && !line.empty()) {
+			auto colon = line.find(':');
+			if (colon == line.npos) continue;
+			std::string name = line.substr(0, colon);
+			for (auto &c: name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+			std::string_view value(line);
+			value = value.substr(colon+1);
+			while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+			if (name == "content-length") contentLength = std::atol(std::string(value).c_str());
+			else if (name == "transfer-encoding" && value.find("chunked") != value.npos) chunked = true;
+			else if (name == "connection" && value.find("close") != value.npos) keepAlive = false;
+		}
+		bool ok = true;
+		if (chunked) {
+			for(;;) {
+				if (!readLine(line)) {ok = false;break;}
+				std::size_t sz = std::strtoul(line.c_str(), nullptr, 16);
+				if (sz == 0) {
+					while (readLine(line) && !line.empty()) {}
+					break;
+				}
+				if (!readBytes(sz+2)) {ok = false;break;}
+				bodySize += sz;
+			}
+		} else if (contentLength >= 0) {
+			ok = readBytes(contentLength);
+			bodySize = contentLength;
+		} else {
+			while (readMore()) {}
+			bodySize = buffer.size();
+			keepAlive = false;
+		}
+		if (!ok) {
+			close();
+			return 0;
+		}
+		if (!keepAlive) close();
+		return status;
+	}
+	return 0;
+}
+
+static bool parseMix(const char *mix, unsigned int (&weights)[endpointCount]) {
+	for (auto &w: weights) w = 0;
+	std::string_view m(mix);
+	while (!m.empty()) {
+		auto sep = m.find(',');
+		auto item = m.substr(0, sep);
+		m = sep == m.npos?std::string_view():m.substr(sep+1);
+		auto eq = item.find('=');
+		if (eq == item.npos) return false;
+		auto name = item.substr(0, eq);
+		int idx = -1;
+		for (int i = 0; i < endpointCount; i++) if (name == endpointNames[i]) idx = i;
+		if (idx < 0) return false;
+		weights[idx] = std::strtoul(std::string(item.substr(eq+1)).c_str(), nullptr, 10);
+	}
+	return true;
+}
+
+static std::vector<SymbolInfo> loadSymbols(const sockaddr_in &addr, const std::string &host) {
+	std::vector<SymbolInfo> out;
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0) {
+		if (fd >= 0) ::close(fd);
+		return out;
+	}
+	std::string req = "GET /symbols HTTP/1.0\r\nHost: "+host+"\r\n\r\n";
+	::send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+	std::string resp;
+	char buff[65536];
+	ssize_t r;
+	while ((r = ::recv(fd, buff, sizeof(buff), 0)) > 0) resp.append(buff, r);
+	::close(fd);
+	auto pos = resp.find("\r\n\r\n");
+	if (pos == resp.npos) return out;
+	std::size_t i = pos + 4;
+	JsonReader rd([&]() -> int {
+		return i < resp.size()?static_cast<unsigned char>(resp[i++]):-1;
+	});
+	using Reader = decltype(rd);
+	if (rd.next() != Reader::begin_object) return out;
+	while (rd.next() == Reader::key) {
+		SymbolInfo nfo;
+		nfo.name = rd.getText();
+		if (rd.next() != Reader::begin_array) break;
+		std::uint64_t v[3] = {0,0,0};
+		int idx = 0;
+		Reader::Token t;
+		while ((t = rd.next()) == Reader::number) {
+			if (idx < 3) v[idx++] = rd.getUInt();
+		}
+		if (t != Reader::end_array) break;
+		nfo.firstDay = v[0];
+		nfo.lastDay = v[1];
+		if (nfo.name != "usd" && v[2]) out.push_back(std::move(nfo));
+	}
+	return out;
+}
+
+int main(int argc, char **argv) {
+	std::string address = "127.0.0.1";
+	unsigned int port = 3456;
+	unsigned int connections = 8;
+	unsigned int duration = 10;
+	unsigned int seed = 1;
+	unsigned int weights[endpointCount];
+	parseMix("minute=40,daily=15,ohlc=25,history=15,collector=5", weights);
+	int opt;
+	while ((opt = getopt(argc, argv, "a:p:c:t:m:r:")) != -1) {
+		switch (opt) {
+		case 'a': address = optarg;break;
+		case 'p': port = std::strtoul(optarg, nullptr, 10);break;
+		case 'c': connections = std::max(1UL, std::strtoul(optarg, nullptr, 10));break;
+		case 't': duration = std::strtoul(optarg, nullptr, 10);break;
+		case 'r': seed = std::strtoul(optarg, nullptr, 10);break;
+		case 'm': if (parseMix(optarg, weights)) break;
+			std::fprintf(stderr, "Invalid mix: %s\n", optarg);
+			return 1;
+		default:
+			std::fprintf(stderr, "Usage: %s [-a address] [-p port] [-c connections] [-t seconds] [-m mix] [-r seed]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+		std::fprintf(stderr, "Invalid address: %s\n", address.c_str());
+		return 1;
+	}
+	std::string host = address+":"+std::to_string(port);
+
+	auto symbols = loadSymbols(addr, host);
+	if (symbols.empty()) {
+		std::fprintf(stderr, "No symbols available at %s\n", host.c_str());
+		return 1;
+	}
+	std::printf("Symbols: %zu, connections: %u, duration: %u s\n", symbols.size(), connections, duration);
+
+	std::vector<unsigned int> cumulative;
+	unsigned int totalWeight = 0;
+	for (auto w: weights) cumulative.push_back(totalWeight += w);
+	if (totalWeight == 0) {
+		std::fprintf(stderr, "Empty mix\n");
+		return 1;
+	}
+
+	EndpointStats stats[endpointCount];
+	constexpr std::uint64_t daysec = 24*60*60;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(duration);
+
+	auto worker = [&](unsigned int id) {
+		std::mt19937_64 rnd(seed * 7919 + id);
+		Connection conn(addr);
+		std::string req;
+		std::string body;
+		while (std::chrono::steady_clock::now() < deadline) {
+			unsigned int r = rnd() % totalWeight;
+			int ep = 0;
+			while (cumulative[ep] <= r) ep++;
+			const SymbolInfo &s = symbols[rnd() % symbols.size()];
+			const SymbolInfo &c = symbols[rnd() % symbols.size()];
+			//30% of pairs are cross pairs
+			std::string currency = rnd() % 10 < 3 && c.name != s.name?c.name:"usd";
+			std::uint64_t day = s.firstDay + rnd() % (s.lastDay - s.firstDay + 1);
+			std::string path;
+			switch (ep) {
+			case minute: path = "/minute?asset="+s.name+"&currency="+currency
+						+"&from="+std::to_string(day*daysec)+"&to="+std::to_string((day+1)*daysec);
+						break;
+			case daily: path = "/daily?asset="+s.name+"&currency="+currency;
+						break;
+			case ohlc: path = "/ohlc?asset="+s.name+"&currency="+currency
+						+"&from="+std::to_string(day*daysec)+"&to="+std::to_string((day+30)*daysec)+"&timeframe=60";
+						break;
+			case history: path = "/history/"+std::to_string(day*daysec + (rnd() % 1440)*60);
+						break;
+			default: path = "/collector/binance";
+						break;
+			}
+			if (ep == collector) {
+				body = "[";
+				for (std::size_t i = 0; i < symbols.size() && i < 200; i++) {
+					if (i) body.push_back(',');
+					std::string sym = symbols[i].name;
+					for (auto &ch: sym) ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+					body.append("{\"symbol\":\"").append(sym).append("USDT\",\"price\":\"")
+						.append(std::to_string(1.0 + (rnd() % 100000) / 100.0)).append("\"}");
+				}
+				body.push_back(']');
+				req = "POST "+path+" HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: "
+						+std::to_string(body.size())+"\r\n\r\n"+body;
+			} else {
+				req = "GET "+path+" HTTP/1.1\r\nHost: "+host+"\r\n\r\n";
+			}
+			auto start = std::chrono::steady_clock::now();
+			std::size_t bodySize;
+			int status = conn.request(req, bodySize);
+			auto dur = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			EndpointStats &st = stats[ep];
+			st.requests.add();
+			st.bytes.add(bodySize);
+			if (status == 0 || status >= 400) st.errors.add();
+			else st.latency.record(dur);
+			if (status == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < connections; i++) threads.emplace_back(worker, i);
+	for (auto &t: threads) t.join();
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%-10s %9s %7s %10s %9s %9s %9s %9s %9s %9s\n",
+			"endpoint","requests","errors","req/s","MB/s","p50 ms","p90 ms","p99 ms","p99.9 ms","max ms");
+	std::uint64_t totalReq = 0, totalErr = 0, totalBytes = 0;
+	for (int i = 0; i < endpointCount; i++) {
+		auto snap = stats[i].latency.snapshot();
+		std::uint64_t req = stats[i].requests.get();
+		if (req == 0) continue;
+		std::uint64_t bytes = stats[i].bytes.get();
+		totalReq += req;
+		totalErr += stats[i].errors.get();
+		totalBytes += bytes;
+		std::printf("%-10s %9llu %7llu %10.1f %9.2f %9.3f %9.3f %9.3f %9.3f %9.3f\n", endpointNames[i],
+				static_cast<unsigned long long>(req), static_cast<unsigned long long>(stats[i].errors.get()),
+				req/secs, bytes/secs/(1024.0*1024.0),
+				snap.quantile(0.5)*0.001, snap.quantile(0.9)*0.001, snap.quantile(0.99)*0.001,
+				snap.quantile(0.999)*0.001, snap.quantile(1.0)*0.001);
+	}
+	std::printf("%-10s %9llu %7llu %10.1f %9.2f\n", "total", static_cast<unsigned long long>(totalReq),
+			static_cast<unsigned long long>(totalErr), totalReq/secs, totalBytes/secs/(1024.0*1024.0));
+	return 0;
+}
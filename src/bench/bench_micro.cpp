@@ -0,0 +1,206 @@
+/*
+ * bench_micro.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ *
+ * Microbenchmarks of the data paths on a temporary database:
+ * iterateData (usd, inverse and cross branches), OHLC folding from minutes
+ * and from stored candles, emission in all output formats and rebuild of the OHLC views.
+ *
+ *   bench_micro [-d days] [-c] [-p path]
+ *
+ *   -d days of minute data (default 60)
+ *   -c use columnar storage (days are sealed before the benchmark)
+ *   -p path of the temporary database (default /tmp/prices_bench_XXXXXX, removed at exit)
+ */
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "../docdb/src/docdblib/db.h"
+#include "../docdb/src/docdblib/json_map.h"
+#include "../main/group_commit.h"
+#include "../main/iterate_data.h"
+#include "../main/ohlc.h"
+#include "../main/output_format.h"
+#include "../main/metrics.h"
+#include "../main/price_store.h"
+
+using namespace docdb;
+
+struct StringStream {
+	std::string data;
+	void write(std::string_view s) {data.append(s);}
+};
+
+template<typename Fn>
+static void bench(const char *name, const char *unit, Fn &&fn) {
+	auto start = std::chrono::steady_clock::now();
+	std::size_t items = fn();
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-28s %10.3f ms %12zu %-8s %14.0f %s/s\n", name, secs*1000, items, unit, items/std::max(secs,1e-9), unit);
+}
+
+static void fill(DB &db, JsonMap &pmap, std::uint64_t start, unsigned int days) {
+	std::mt19937_64 rnd(1);
+	std::normal_distribution<double> norm(0.0, 1.0);
+	std::uniform_real_distribution<double> uni(0.0, 1.0);
+	double btc = 20000, eth = 1500, ltc = 80;
+	for (unsigned int d = 0; d < days; d++) {
+		Batch batch;
+		for (std::uint64_t t = start + d*PriceStore::daysec; t < start + (d+1)*PriceStore::daysec; t+=60) {
+			btc *= std::exp(norm(rnd)*0.001);
+			eth *= std::exp(norm(rnd)*0.0015);
+			ltc *= std::exp(norm(rnd)*0.002);
+			//btc is dense, eth has short gaps, ltc is sparse
+			pmap.set(batch, {"btc", t}, btc);
+			if (uni(rnd) > 0.1) pmap.set(batch, {"eth", t}, eth);
+			if (uni(rnd) > 0.9) pmap.set(batch, {"ltc", t}, ltc);
+		}
+		db.commitBatch(batch);
+	}
+}
+
+int main(int argc, char **argv) {
+	unsigned int days = 60;
+	bool columnar = false;
+	std::string path;
+	int opt;
+	while ((opt = getopt(argc, argv, "d:cp:")) != -1) {
+		switch (opt) {
+		case 'd': days = std::strtoul(optarg, nullptr, 10);break;
+		case 'c': columnar = true;break;
+		case 'p': path = optarg;break;
+		default: std::fprintf(stderr, "Usage: %s [-d days] [-c] [-p path]\n", argv[0]); return 1;
+		}
+	}
+	bool temporary = path.empty();
+	if (temporary) {
+		char tmpl[] = "/tmp/prices_bench_XXXXXX";
+		if (mkdtemp(tmpl) == nullptr) {
+			std::perror("mkdtemp");
+			return 1;
+		}
+		path = tmpl;
+	}
+
+	{
+		Config cfg;
+		cfg.write_buffer_size = 16*1024*1024;
+		cfg.max_file_size = 2*1024*1024;
+		cfg.block_cache = DB::createCache(32*1024*1024);
+		DB db(path, cfg);
+		JsonMap pmap(db, "pmap");
+		Metrics metrics;
+		GroupCommit writer(db, std::chrono::microseconds(0), 8*1024*1024, metrics);
+		PriceStore store(db, pmap, columnar?PriceStore::Mode::columnar:PriceStore::Mode::json);
+
+		std::uint64_t start = 1600000000/PriceStore::daysec*PriceStore::daysec;
+		bench("fill", "prices", [&]{
+			fill(db, pmap, start, days);
+			return static_cast<std::size_t>(days) * 1440 * 2;
+		});
+		if (columnar) {
+			bench("seal", "days", [&]{
+				for (const char *symbol: {"btc","eth","ltc"}) {
+					store.seal(writer, symbol, start/PriceStore::daysec + days);
+				}
+				return static_cast<std::size_t>(days);
+			});
+		}
+
+		std::vector<std::pair<std::uint64_t, double> > series;
+		auto collect = [&](std::uint64_t t, double v) {
+			series.emplace_back(t, v);
+		};
+		bench("iterateData usd", "points", [&]{
+			series.clear();
+			iterateData(store, "btc", "usd", 0, 0, 1, false, collect);
+			return series.size();
+		});
+		bench("iterateData inverse", "points", [&]{
+			series.clear();
+			iterateData(store, "usd", "btc", 0, 0, 1, false, collect);
+			return series.size();
+		});
+		bench("iterateData cross dense", "points", [&]{
+			series.clear();
+			iterateData(store, "eth", "btc", 0, 0, 1, false, collect);
+			return series.size();
+		});
+		bench("iterateData cross sparse", "points", [&]{
+			series.clear();
+			iterateData(store, "ltc", "btc", 0, 0, 1, false, collect);
+			return series.size();
+		});
+		bench("iterateData cross fill", "points", [&]{
+			series.clear();
+			iterateData(store, "ltc", "btc", 0, 0, 1, true, collect);
+			return series.size();
+		});
+
+		series.clear();
+		iterateData(store, "btc", "usd", 0, 0, 1, false, collect);
+		for (auto fmt: {OutputFormat::json, OutputFormat::csv, OutputFormat::binary, OutputFormat::binary_delta}) {
+			static const char *names[] = {"emit json", "emit csv", "emit binary", "emit binary delta"};
+			StringStream out;
+			bench(names[static_cast<int>(fmt)], "points", [&]{
+				SeriesWriter<StringStream> wr(out, fmt, 1, ",\r\n");
+				wr.begin();
+				for (const auto &p: series) wr.push(p.first, &p.second);
+				wr.end();
+				return series.size();
+			});
+			std::printf("%-28s %10.3f MB\n", "", out.data.size()/(1024.0*1024.0));
+		}
+
+		OHLCViews views(store);
+		bench("rebuild ohlc views", "days", [&]{
+			views.populate(db, pmap);
+			return static_cast<std::size_t>(days);
+		});
+		bench("ohlc 1h from minutes", "candles", [&]{
+			std::vector<std::array<double,4> > candles;
+			std::uint64_t lastFrame = 0;
+			iterateData(store, "btc", "usd", 0, 0, 1, false, [&](std::uint64_t t, double v){
+				std::uint64_t f = t/3600;
+				if (f != lastFrame) {
+					candles.push_back({v,v,v,v});
+					lastFrame = f;
+				} else {
+					auto &c = candles.back();
+					c[1] = std::max(c[1], v);
+					c[2] = std::min(c[2], v);
+					c[3] = v;
+				}
+			});
+			return candles.size();
+		});
+		bench("ohlc 1h stored", "candles", [&]{
+			std::size_t candles = 0;
+			views.range(3600, "btc", 0, std::numeric_limits<std::uint64_t>::max(), [&](std::uint64_t, double, double, double, double){
+				candles++;
+			});
+			return candles;
+		});
+		bench("ohlc 1d stored", "candles", [&]{
+			std::size_t candles = 0;
+			views.range(86400, "btc", 0, std::numeric_limits<std::uint64_t>::max(), [&](std::uint64_t, double, double, double, double){
+				candles++;
+			});
+			return candles;
+		});
+	}
+
+	if (temporary) std::filesystem::remove_all(path);
+	return 0;
+}
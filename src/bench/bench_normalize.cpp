@@ -0,0 +1,140 @@
+/*
+ * bench_normalize.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ *
+ * Feeds exchange payloads through the streaming parser, the normalizers
+ * and the ingestion pipeline and reports rows/s. Without arguments, synthetic
+ * payloads shaped as responses of the exchanges are used. A recorded payload
+ * can be passed as arguments: bench_normalize <source> <file> [<source> <file> ...]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../main/normalizer.h"
+
+static std::string symbolName(std::mt19937 &rnd, std::size_t i) {
+	static const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	std::string s;
+	std::size_t len = 3 + rnd() % 3;
+	for (std::size_t j = 0; j < len; j++) s.push_back(letters[(i*7 + j*13 + rnd()) % 26]);
+	return s;
+}
+
+static std::string genBinance(std::size_t rows) {
+	std::mt19937 rnd(1);
+	static const char *quotes[] = {"USDT","BUSD","BTC","ETH","EUR"};
+	std::ostringstream out;
+	out << "[";
+	for (std::size_t i = 0; i < rows; i++) {
+		if (i) out << ",";
+		out << "{\"symbol\":\"" << symbolName(rnd, i/3) << quotes[rnd() % 5]
+			<< "\",\"price\":\"" << (rnd() % 1000000) / 100.0 << "\"}";
+	}
+	out << "]";
+	return out.str();
+}
+
+static std::string genBitfinex(std::size_t rows) {
+	std::mt19937 rnd(2);
+	std::ostringstream out;
+	out << "[";
+	for (std::size_t i = 0; i < rows; i++) {
+		if (i) out << ",";
+		double p = (rnd() % 1000000) / 100.0;
+		out << "[\"t" << symbolName(rnd, i) << (i % 2?":USD":"USD") << "\"," << p << ",12.5," << p*1.001
+			<< ",8.25," << p*0.01 << ",0.0012," << p << ",105234.5," << p*1.05 << "," << p*0.95 << "]";
+	}
+	out << "]";
+	return out.str();
+}
+
+static std::string genFtx(std::size_t rows) {
+	std::mt19937 rnd(3);
+	std::ostringstream out;
+	out << "{\"success\":true,\"result\":[";
+	for (std::size_t i = 0; i < rows; i++) {
+		if (i) out << ",";
+		std::string base = symbolName(rnd, i);
+		double p = (rnd() % 1000000) / 100.0;
+		if (i % 3 == 0) {
+			out << "{\"name\":\"" << base << "-0325\",\"enabled\":true,\"postOnly\":false,\"priceIncrement\":0.5,"
+				<< "\"type\":\"future\",\"baseCurrency\":null,\"quoteCurrency\":null,\"underlying\":\"" << base
+				<< "\",\"price\":" << p << ",\"bid\":" << p << ",\"ask\":" << p << ",\"volumeUsd24h\":1234567.8}";
+		} else {
+			out << "{\"name\":\"" << base << "/USD\",\"enabled\":true,\"postOnly\":false,\"priceIncrement\":0.5,"
+				<< "\"type\":\"spot\",\"baseCurrency\":\"" << base << "\",\"quoteCurrency\":\"" << (i%2?"USD":"USDT")
+				<< "\",\"underlying\":null,\"price\":" << p << ",\"bid\":" << p << ",\"ask\":" << p << ",\"volumeUsd24h\":1234567.8}";
+		}
+	}
+	out << "]}";
+	return out.str();
+}
+
+static std::string genCryptowatch(std::size_t rows) {
+	std::mt19937 rnd(4);
+	std::ostringstream out;
+	out << "{\"result\":{\"rows\":[";
+	for (std::size_t i = 0; i < rows; i++) {
+		if (i) out << ",";
+		out << "{\"symbol\":\"" << symbolName(rnd, i) << "\",\"price\":" << (rnd() % 1000000) / 100.0 << "}";
+	}
+	out << "]},\"allowance\":{\"cost\":0.015,\"remaining\":9.985}}";
+	return out.str();
+}
+
+static void run(const NormalizerRegistry &reg, const std::string &source, const std::string &payload) {
+	const SourceAdapter *adapter = reg.find(source);
+	if (adapter == nullptr) {
+		std::fprintf(stderr, "Unknown source: %s\n", source.c_str());
+		return;
+	}
+	IngestPipeline pipeline;
+	std::size_t rows = 0;
+	std::size_t iterations = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed;
+	do {
+		IngestSink sink(pipeline);
+		std::size_t pos = 0;
+		rows += NormalizerRegistry::parse([&]() -> int {
+			return pos < payload.size()?static_cast<unsigned char>(payload[pos++]):-1;
+		}, *adapter, sink);
+		sink.finish();
+		iterations++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < 1.0);
+	auto prices = pipeline.commit(60);
+	std::printf("%-12s %8zu rows/payload %12.0f rows/s %8.1f MB/s | symbols %zu\n",
+			source.c_str(), rows/iterations, rows/elapsed,
+			payload.size()*iterations/elapsed/(1024.0*1024.0), prices.size());
+}
+
+int main(int argc, char **argv) {
+	NormalizerRegistry reg;
+	if (argc > 2) {
+		for (int i = 1; i + 1 < argc; i += 2) {
+			std::ifstream f(argv[i+1], std::ios::binary);
+			if (!f) {
+				std::fprintf(stderr, "Can't open: %s\n", argv[i+1]);
+				return 1;
+			}
+			std::ostringstream buff;
+			buff << f.rdbuf();
+			run(reg, argv[i], buff.str());
+		}
+		return 0;
+	}
+	run(reg, "binance", genBinance(3000));
+	run(reg, "bitfinex", genBitfinex(300));
+	run(reg, "ftx", genFtx(800));
+	run(reg, "cryptowatch", genCryptowatch(5000));
+	return 0;
+}
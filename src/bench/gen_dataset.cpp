@@ -0,0 +1,128 @@
+/*
+ * gen_dataset.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ *
+ * Generates synthetic minute prices as a CouchDB dump, which can be loaded
+ * by the /import endpoint:
+ *
+ *   gen_dataset -s 50 -y 2 > dump.json
+ *   curl --data-binary @dump.json http://localhost:3456/import
+ *
+ * Every symbol follows a random walk with its own volatility. Symbols are listed
+ * at random time (later symbols tend to be younger), some are delisted, and all have
+ * outages of random length, so the series contain gaps like the real data.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+struct SymbolState {
+	std::string name;
+	double price;
+	double volatility;
+	std::uint64_t listed;
+	std::uint64_t delisted;
+	std::uint64_t outageEnd = 0;
+};
+
+static void usage(const char *prog) {
+	std::fprintf(stderr,
+			"Usage: %s [-s symbols] [-y years] [-g gaps] [-r seed] [-e end_time] [-o file]\n"
+			"  -s count of symbols (default 20)\n"
+			"  -y years of minute data (default 1)\n"
+			"  -g probability of an outage start per symbol and day (default 0.05)\n"
+			"  -r random seed (default 1)\n"
+			"  -e end time (unix time, default now)\n"
+			"  -o output file (default stdout)\n", prog);
+}
+
+int main(int argc, char **argv) {
+	unsigned int symbols = 20;
+	double years = 1;
+	double gaps = 0.05;
+	unsigned int seed = 1;
+	std::uint64_t end = std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+	const char *outName = nullptr;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:y:g:r:e:o:h")) != -1) {
+		switch (opt) {
+		case 's': symbols = std::strtoul(optarg, nullptr, 10);break;
+		case 'y': years = std::strtod(optarg, nullptr);break;
+		case 'g': gaps = std::strtod(optarg, nullptr);break;
+		case 'r': seed = std::strtoul(optarg, nullptr, 10);break;
+		case 'e': end = std::strtoull(optarg, nullptr, 10);break;
+		case 'o': outName = optarg;break;
+		default: usage(argv[0]); return 1;
+		}
+	}
+
+	FILE *out = outName?std::fopen(outName, "w"):stdout;
+	if (out == nullptr) {
+		std::perror(outName);
+		return 1;
+	}
+
+	static const char *known[] = {"btc","eth","ltc","xrp","bnb","ada","sol","dot","doge","trx",
+			"link","matic","atom","xlm","etc","bch","uni","fil","eos","xmr"};
+	constexpr std::uint64_t daysec = 24*60*60;
+	end = end/60*60;
+	std::uint64_t start = end - static_cast<std::uint64_t>(years * 365 * daysec)/60*60;
+
+	std::mt19937_64 rnd(seed);
+	std::uniform_real_distribution<double> uni(0.0, 1.0);
+	std::normal_distribution<double> norm(0.0, 1.0);
+
+	std::vector<SymbolState> st;
+	for (unsigned int i = 0; i < symbols; i++) {
+		SymbolState s;
+		s.name = i < sizeof(known)/sizeof(known[0])?known[i]:"s"+std::to_string(i);
+		s.price = std::exp(uni(rnd) * 14 - 5);
+		s.volatility = 0.0005 + uni(rnd) * 0.002;
+		//first symbols have full history, later are listed later
+		double age = i < 3?1.0:std::pow(uni(rnd), 0.5 * i / symbols + 0.2);
+		s.listed = end - static_cast<std::uint64_t>((end - start) * age)/60*60;
+		s.delisted = uni(rnd) < 0.05?s.listed + static_cast<std::uint64_t>((end - s.listed) * uni(rnd))/60*60:end + 60;
+		st.push_back(std::move(s));
+	}
+
+	double outageChance = gaps / (daysec/60);
+	std::uint64_t rows = 0, prices = 0;
+	std::fputs("{\"total_rows\":0,\"offset\":0,\"rows\":[\n", out);
+	std::string line;
+	char buff[64];
+	for (std::uint64_t t = start; t < end; t += 60) {
+		line.clear();
+		for (auto &s: st) {
+			if (t < s.listed || t >= s.delisted) continue;
+			s.price *= std::exp(norm(rnd) * s.volatility);
+			if (t < s.outageEnd) continue;
+			if (uni(rnd) < outageChance) {
+				//outages last from minutes to days
+				s.outageEnd = t + static_cast<std::uint64_t>(std::exp(uni(rnd) * 9)) * 60;
+				continue;
+			}
+			if (!line.empty()) line.push_back(',');
+			std::snprintf(buff, sizeof(buff), "\"%s\":%.10g", s.name.c_str(), s.price);
+			line.append(buff);
+			prices++;
+		}
+		if (line.empty()) continue;
+		std::fprintf(out, "%s{\"id\":\"%llu\",\"doc\":{\"_id\":\"%llu\",\"prices\":{%s}}}",
+				rows?",\n":"", static_cast<unsigned long long>(t/10), static_cast<unsigned long long>(t/10), line.c_str());
+		rows++;
+	}
+	std::fputs("\n]}\n", out);
+	if (out != stdout) std::fclose(out);
+	std::fprintf(stderr, "Generated %llu rows, %llu prices, %u symbols\n",
+			static_cast<unsigned long long>(rows), static_cast<unsigned long long>(prices), symbols);
+	return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * kernels.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "kernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace kernels {
+
+namespace {
+
+struct Impl {
+	Level lv;
+	void (*divide)(const double *a, const double *b, double *out, std::size_t n);
+	void (*inverse)(const double *a, double *out, std::size_t n);
+	std::size_t (*boundary)(const std::uint64_t *times, std::size_t n, std::uint64_t limit);
+	void (*minMax)(const double *values, std::size_t n, double &mn, double &mx);
+};
+
+void divideScalar(const double *a, const double *b, double *out, std::size_t n) {
+	for (std::size_t i = 0; i < n; i++) out[i] = a[i]/b[i];
+}
+
+void inverseScalar(const double *a, double *out, std::size_t n) {
+	for (std::size_t i = 0; i < n; i++) out[i] = 1.0/a[i];
+}
+
+std::size_t boundaryScalar(const std::uint64_t *times, std::size_t n, std::uint64_t limit) {
+	std::size_t i = 0;
+	while (i < n && times[i] < limit) i++;
+	return i;
+}
+
+void minMaxScalar(const double *values, std::size_t n, double &mn, double &mx) {
+	double l = values[0], h = values[0];
+	for (std::size_t i = 1; i < n; i++) {
+		l = std::min(l, values[i]);
+		h = std::max(h, values[i]);
+	}
+	mn = l;
+	mx = h;
+}
+
+#ifdef KERNELS_X86
+
+__attribute__((target("sse2")))
+void divideSSE2(const double *a, const double *b, double *out, std::size_t n) {
+	std::size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		_mm_storeu_pd(out+i, _mm_div_pd(_mm_loadu_pd(a+i), _mm_loadu_pd(b+i)));
+	}
+	divideScalar(a+i, b+i, out+i, n-i);
+}
+
+__attribute__((target("sse2")))
+void inverseSSE2(const double *a, double *out, std::size_t n) {
+	const __m128d one = _mm_set1_pd(1.0);
+	std::size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		_mm_storeu_pd(out+i, _mm_div_pd(one, _mm_loadu_pd(a+i)));
+	}
+	inverseScalar(a+i, out+i, n-i);
+}
+
+__attribute__((target("sse2")))
+void minMaxSSE2(const double *values, std::size_t n, double &mn, double &mx) {
+	if (n < 4) {
+		minMaxScalar(values, n, mn, mx);
+		return;
+	}
+	__m128d l = _mm_loadu_pd(values);
+	__m128d h = l;
+	std::size_t i = 2;
+	for (; i + 2 <= n; i += 2) {
+		__m128d v = _mm_loadu_pd(values+i);
+		l = _mm_min_pd(l, v);
+		h = _mm_max_pd(h, v);
+	}
+	double lb[2], hb[2];
+	_mm_storeu_pd(lb, l);
+	_mm_storeu_pd(hb, h);
+	mn = std::min(lb[0], lb[1]);
+	mx = std::max(hb[0], hb[1]);
+	for (; i < n; i++) {
+		mn = std::min(mn, values[i]);
+		mx = std::max(mx, values[i]);
+	}
+}
+
+__attribute__((target("avx2")))
+void divideAVX2(const double *a, const double *b, double *out, std::size_t n) {
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm256_storeu_pd(out+i, _mm256_div_pd(_mm256_loadu_pd(a+i), _mm256_loadu_pd(b+i)));
+	}
+	divideScalar(a+i, b+i, out+i, n-i);
+}
+
+__attribute__((target("avx2")))
+void inverseAVX2(const double *a, double *out, std::size_t n) {
+	const __m256d one = _mm256_set1_pd(1.0);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm256_storeu_pd(out+i, _mm256_div_pd(one, _mm256_loadu_pd(a+i)));
+	}
+	inverseScalar(a+i, out+i, n-i);
+}
+
+__attribute__((target("avx2")))
+std::size_t boundaryAVX2(const std::uint64_t *times, std::size_t n, std::uint64_t limit) {
+	//times are unix times, so signed comparison is safe
+	if (limit > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) return boundaryScalar(times, n, limit);
+	const __m256i lm = _mm256_set1_epi64x(static_cast<std::int64_t>(limit) - 1);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(times+i));
+		int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(t, lm)));
+		if (mask) return i + __builtin_ctz(mask);
+	}
+	return i + boundaryScalar(times+i, n-i, limit);
+}
+
+__attribute__((target("avx2")))
+void minMaxAVX2(const double *values, std::size_t n, double &mn, double &mx) {
+	if (n < 8) {
+		minMaxScalar(values, n, mn, mx);
+		return;
+	}
+	__m256d l = _mm256_loadu_pd(values);
+	__m256d h = l;
+	std::size_t i = 4;
+	for (; i + 4 <= n; i += 4) {
+		__m256d v = _mm256_loadu_pd(values+i);
+		l = _mm256_min_pd(l, v);
+		h = _mm256_max_pd(h, v);
+	}
+	double lb[4], hb[4];
+	_mm256_storeu_pd(lb, l);
+	_mm256_storeu_pd(hb, h);
+	mn = std::min(std::min(lb[0], lb[1]), std::min(lb[2], lb[3]));
+	mx = std::max(std::max(hb[0], hb[1]), std::max(hb[2], hb[3]));
+	for (; i < n; i++) {
+		mn = std::min(mn, values[i]);
+		mx = std::max(mx, values[i]);
+	}
+}
+
+#endif
+
+const Impl implScalar = {Level::scalar, divideScalar, inverseScalar, boundaryScalar, minMaxScalar};
+#ifdef KERNELS_X86
+const Impl implSSE2 = {Level::sse2, divideSSE2, inverseSSE2, boundaryScalar, minMaxSSE2};
+const Impl implAVX2 = {Level::avx2, divideAVX2, inverseAVX2, boundaryAVX2, minMaxAVX2};
+#endif
+
+const Impl *select(Level lv) {
+#ifdef KERNELS_X86
+	__builtin_cpu_init();
+	if (lv >= Level::avx2 && __builtin_cpu_supports("avx2")) return &implAVX2;
+	if (lv >= Level::sse2 && __builtin_cpu_supports("sse2")) return &implSSE2;
+#endif
+	return &implScalar;
+}
+
+std::atomic<const Impl *> active = nullptr;
+
+const Impl &impl() {
+	const Impl *p = active.load(std::memory_order_relaxed);
+	if (p == nullptr) {
+		p = select(Level::avx2);
+		active.store(p, std::memory_order_relaxed);
+	}
+	return *p;
+}
+
+}
+
+Level level() {
+	return impl().lv;
+}
+
+Level setLevel(Level lv) {
+	const Impl *p = select(lv);
+	active.store(p, std::memory_order_relaxed);
+	return p->lv;
+}
+
+const char *levelName(Level lv) {
+	switch (lv) {
+	case Level::avx2: return "avx2";
+	case Level::sse2: return "sse2";
+	default: return "scalar";
+	}
+}
+
+void divide(const double *a, const double *b, double *out, std::size_t n) {
+	impl().divide(a, b, out, n);
+}
+
+void inverse(const double *a, double *out, std::size_t n) {
+	impl().inverse(a, out, n);
+}
+
+std::size_t boundary(const std::uint64_t *times, std::size_t n, std::uint64_t limit) {
+	return impl().boundary(times, n, limit);
+}
+
+void minMax(const double *values, std::size_t n, double &mn, double &mx) {
+	impl().minMax(values, n, mn, mx);
+}
+
+std::size_t foldOHLC(const std::uint64_t *times, const double *prices, std::size_t n, std::uint64_t tfrm, Candle *out) {
+	//vectors don't pay off in short frames (few minutes per frame)
+	const Impl &k = tfrm < 16*60?implScalar:impl();
+	std::size_t cnt = 0;
+	std::size_t i = 0;
+	while (i < n) {
+		std::uint64_t frame = times[i]/tfrm*tfrm;
+		std::size_t j = i + 1 + k.boundary(times+i+1, n-i-1, frame+tfrm);
+		Candle &c = out[cnt++];
+		c.t = frame;
+		c.o = prices[i];
+		c.c = prices[j-1];
+		k.minMax(prices+i, j-i, c.l, c.h);
+		i = j;
+	}
+	return cnt;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+ * kernels.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_BENCH_KERNELS_H_
+#define SRC_BENCH_KERNELS_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "../main/candle.h"
+
+///Vectorized kernels of the read path, measured by bench_kernels
+/**
+ * Every kernel has AVX2, SSE2 and scalar implementation. The best implementation
+ * supported by the CPU is selected at the first use, it can be changed by setLevel().
+ *
+ * The server doesn't use them, staging prices for the kernels costs more than the kernels
+ * save (see bench_kernels), the read path folds items one at a time
+ */
+namespace kernels {
+
+enum class Level {
+	scalar,
+	sse2,
+	avx2
+};
+
+///Returns active level
+Level level();
+///Selects level, returns actually selected level (limited by the CPU)
+Level setLevel(Level lv);
+///Returns name of the level
+const char *levelName(Level lv);
+
+///out[i] = a[i]/b[i]
+void divide(const double *a, const double *b, double *out, std::size_t n);
+///out[i] = 1.0/a[i]
+void inverse(const double *a, double *out, std::size_t n);
+///Returns index of the first time, which is not less than limit (times must be ascending), or n
+std::size_t boundary(const std::uint64_t *times, std::size_t n, std::uint64_t limit);
+///Computes minimum and maximum of values (n > 0)
+void minMax(const double *values, std::size_t n, double &mn, double &mx);
+
+///Folds prices to candles
+/**
+ * @param times ascending times
+ * @param prices prices
+ * @param n count of prices
+ * @param tfrm timeframe in seconds
+ * @param out output candles, must have space for n candles
+ * @return count of candles
+ */
+std::size_t foldOHLC(const std::uint64_t *times, const double *prices, std::size_t n, std::uint64_t tfrm, Candle *out);
+
+}
+
+#endif /* SRC_BENCH_KERNELS_H_ */
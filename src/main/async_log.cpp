@@ -0,0 +1,76 @@
+/*
+ * async_log.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "async_log.h"
+
+#include <chrono>
+
+AsyncLog::AsyncLog(std::size_t capacity, std::function<void(const std::string &)> writer)
+	:writer(std::move(writer)) {
+	std::size_t sz = 2;
+	while (sz < capacity) sz <<= 1;
+	cells = std::make_unique<Cell[]>(sz);
+	for (std::size_t i = 0; i < sz; i++) cells[i].seq.store(i, std::memory_order_relaxed);
+	mask = sz - 1;
+	thr = std::thread([this]{worker();});
+}
+
+AsyncLog::~AsyncLog() {
+	stopping = true;
+	thr.join();
+}
+
+bool AsyncLog::push(std::string &&line) {
+	//bounded MPMC queue (D. Vyukov), only single consumer is used
+	std::size_t pos = head.load(std::memory_order_relaxed);
+	for(;;) {
+		Cell &c = cells[pos & mask];
+		std::size_t seq = c.seq.load(std::memory_order_acquire);
+		auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+		if (dif == 0) {
+			if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				c.data = std::move(line);
+				c.seq.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		} else if (dif < 0) {
+			droppedCnt++;
+			return false;
+		} else {
+			pos = head.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool AsyncLog::pop(std::string &line) {
+	Cell &c = cells[tail & mask];
+	std::size_t seq = c.seq.load(std::memory_order_acquire);
+	if (seq != tail + 1) return false;
+	line = std::move(c.data);
+	c.seq.store(tail + mask + 1, std::memory_order_release);
+	tail++;
+	return true;
+}
+
+void AsyncLog::worker() {
+	std::string line;
+	for(;;) {
+		bool any = false;
+		while (pop(line)) {
+			any = true;
+			try {
+				writer(line);
+			} catch (...) {
+
+			}
+		}
+		if (!any) {
+			if (stopping) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	}
+}
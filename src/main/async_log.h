@@ -0,0 +1,62 @@
+/*
+ * async_log.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_ASYNC_LOG_H_
+#define SRC_MAIN_ASYNC_LOG_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+///Writes log lines on a background thread
+/**
+ * Lines are passed through a bounded lock-free queue, so the caller never waits for
+ * the log output. When the queue is full, the line is dropped and counted.
+ */
+class AsyncLog {
+public:
+	///Construct the log
+	/**
+	 * @param capacity capacity of the queue (rounded up to power of two)
+	 * @param writer function, which writes the line (called on background thread)
+	 */
+	AsyncLog(std::size_t capacity, std::function<void(const std::string &)> writer);
+	~AsyncLog();
+
+	///Queues the line
+	/**
+	 * @retval true queued
+	 * @retval false queue is full, line dropped
+	 */
+	bool push(std::string &&line);
+
+	///Count of dropped lines
+	std::uint64_t dropped() const {return droppedCnt;}
+
+protected:
+	struct Cell {
+		std::atomic<std::size_t> seq;
+		std::string data;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	std::size_t mask;
+	alignas(64) std::atomic<std::size_t> head = 0;
+	alignas(64) std::size_t tail = 0;
+	std::atomic<std::uint64_t> droppedCnt = 0;
+	std::atomic<bool> stopping = false;
+	std::function<void(const std::string &)> writer;
+	std::thread thr;
+
+	bool pop(std::string &line);
+	void worker();
+};
+
+#endif /* SRC_MAIN_ASYNC_LOG_H_ */
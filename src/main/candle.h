@@ -0,0 +1,20 @@
+/*
+ * candle.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_CANDLE_H_
+#define SRC_MAIN_CANDLE_H_
+
+#include <cstdint>
+
+///Candle of a timeframe
+struct Candle {
+	///start of the frame (time of the item, when it is read by itemValue())
+	std::uint64_t t;
+	double o,h,l,c;
+};
+
+#endif /* SRC_MAIN_CANDLE_H_ */
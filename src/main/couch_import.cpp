@@ -0,0 +1,44 @@
+/*
+ * couch_import.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "couch_import.h"
+
+#include <algorithm>
+#include <imtjson/object.h>
+
+void CouchImporter::writeRow(std::uint64_t time) {
+	for (const auto &p: rowPrices) {
+		pmap.set(batch, {p.first, time}, p.second);
+		if (symbols.find(p.first) == symbols.end()) symbols.emplace(p.first);
+	}
+	stats.rows++;
+	stats.prices += rowPrices.size();
+	pending += rowPrices.size();
+	if (batch.ApproximateSize() >= batchSize) flush();
+}
+
+void CouchImporter::flush() {
+	if (pending == 0) return;
+	writer.commit(batch);
+	batch.Clear();
+	pending = 0;
+	stats.batches++;
+}
+
+json::Value CouchImporter::Stats::toJson() const {
+	double secs = std::max(seconds, 1e-6);
+	json::Object obj;
+	obj.set("rows", rows);
+	obj.set("prices", prices);
+	obj.set("bytes", bytes);
+	obj.set("batches", batches);
+	obj.set("seconds", seconds);
+	obj.set("rows_per_sec", rows/secs);
+	obj.set("mb_per_sec", bytes/secs/(1024.0*1024.0));
+	obj.set("complete", complete);
+	return json::Value(obj);
+}
@@ -0,0 +1,171 @@
+/*
+ * couch_import.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_COUCH_IMPORT_H_
+#define SRC_MAIN_COUCH_IMPORT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <imtjson/value.h>
+#include "../docdb/src/docdblib/db.h"
+#include "../docdb/src/docdblib/json_map.h"
+#include "group_commit.h"
+#include "json_reader.h"
+
+///Imports CouchDB dump (result of _all_docs?include_docs=true) into the price map
+/**
+ * The dump is parsed as a stream, one row at a time, so memory usage doesn't depend
+ * on size of the dump. Writes are collected into batches limited by size.
+ */
+class CouchImporter {
+public:
+
+	struct Stats {
+		std::uint64_t rows = 0;
+		std::uint64_t prices = 0;
+		std::uint64_t bytes = 0;
+		std::uint64_t batches = 0;
+		double seconds = 0;
+		bool complete = false;
+
+		json::Value toJson() const;
+	};
+
+	///Construct importer
+	/**
+	 * @param writer writer of the database
+	 * @param pmap price map
+	 * @param batchSize approximate size of one batch in bytes
+	 */
+	CouchImporter(GroupCommit &writer, docdb::JsonMap &pmap, std::size_t batchSize)
+		:writer(writer),pmap(pmap),batchSize(batchSize) {}
+
+	///Runs import
+	/**
+	 * @param src function, returns next character of the dump or -1 at the end
+	 * @return statistics, complete is false, when the dump is truncated or malformed (rows
+	 * read before the error are imported)
+	 */
+	template<typename Source>
+	Stats run(Source &&src);
+
+	///Symbols touched by the import
+	const std::set<std::string, std::less<> > &getSymbols() const {return symbols;}
+
+protected:
+	GroupCommit &writer;
+	docdb::JsonMap &pmap;
+	std::size_t batchSize;
+	docdb::Batch batch;
+	std::size_t pending = 0;
+	std::set<std::string, std::less<> > symbols;
+	std::vector<std::pair<std::string, double> > rowPrices;
+	Stats stats;
+
+	void writeRow(std::uint64_t time);
+	void flush();
+
+	template<typename Reader>
+	static bool skipValue(Reader &rd);
+	template<typename Reader>
+	bool readRow(Reader &rd);
+};
+
+template<typename Reader>
+inline bool CouchImporter::skipValue(Reader &rd) {
+	auto t = rd.next();
+	if (t == Reader::begin_object || t == Reader::begin_array) rd.skip();
+	return t != Reader::end && t != Reader::error;
+}
+
+template<typename Reader>
+inline bool CouchImporter::readRow(Reader &rd) {
+	std::uint64_t time = 0;
+	rowPrices.clear();
+	for(;;) {
+		auto t = rd.next();
+		if (t == Reader::end_object) break;
+		if (t != Reader::key) return false;
+		if (rd.getText() == "id") {
+			t = rd.next();
+			if (t == Reader::string || t == Reader::number) time = rd.getUInt()*10;
+			else if (t == Reader::begin_object || t == Reader::begin_array) rd.skip();
+		} else if (rd.getText() == "doc") {
+			t = rd.next();
+			if (t != Reader::begin_object) {
+				if (t == Reader::begin_array) rd.skip();
+				continue;
+			}
+			while ((t = rd.next()) == Reader::key) {
+				if (rd.getText() != "prices") {
+					if (!skipValue(rd)) return false;
+					continue;
+				}
+				t = rd.next();
+				if (t != Reader::begin_object) {
+					if (t == Reader::begin_array) rd.skip();
+					continue;
+				}
+				while ((t = rd.next()) == Reader::key) {
+					std::string symbol(rd.getText());
+					t = rd.next();
+					if (t == Reader::number) rowPrices.emplace_back(std::move(symbol), rd.getNumber());
+					else if (t == Reader::begin_object || t == Reader::begin_array) rd.skip();
+				}
+				if (t != Reader::end_object) return false;
+			}
+			if (t != Reader::end_object) return false;
+		} else if (!skipValue(rd)) {
+			return false;
+		}
+	}
+	if (time) writeRow(time);
+	return true;
+}
+
+template<typename Source>
+inline CouchImporter::Stats CouchImporter::run(Source &&src) {
+	auto start = std::chrono::steady_clock::now();
+	stats = Stats();
+	JsonReader rd([&]() -> int {
+		int c = src();
+		if (c != -1) ++stats.bytes;
+		return c;
+	});
+	using Reader = decltype(rd);
+	for(;;) {
+		auto t = rd.next();
+		if (t == Reader::end || t == Reader::error) break;
+		if (t != Reader::key || rd.depth() != 1 || rd.getText() != "rows") continue;
+		if (rd.next() != Reader::begin_array) break;
+		for(;;) {
+			t = rd.next();
+			if (t == Reader::end_array) {
+				stats.complete = true;
+				break;
+			}
+			if (t == Reader::begin_object) {
+				if (!readRow(rd)) break;
+			} else if (t == Reader::begin_array) {
+				rd.skip();
+			} else if (t == Reader::end || t == Reader::error) {
+				break;
+			}
+		}
+		break;
+	}
+	flush();
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+
+#endif /* SRC_MAIN_COUCH_IMPORT_H_ */
@@ -0,0 +1,167 @@
+/*
+ * daily_record.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_DAILY_RECORD_H_
+#define SRC_MAIN_DAILY_RECORD_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include <imtjson/value.h>
+#include "merge_join.h"
+
+///Record of one day stored in the daily view
+/**
+ * Stored as [mean, open, high, low, close, count, first, last], where first and last
+ * are times of the first and the last minute of the day. Older databases store only
+ * the mean as a number, such record is read with all prices equal to the mean and count 0
+ */
+struct DailyRecord {
+	double mean = 0;
+	double open = 0;
+	double high = 0;
+	double low = 0;
+	double close = 0;
+	std::uint64_t count = 0;
+	std::uint64_t first = 0;
+	std::uint64_t last = 0;
+
+	///Version of the stored format (version 1 stored only the mean)
+	static constexpr unsigned int version = 2;
+
+	enum class Field {mean, open, high, low, close, count, first, last};
+
+	///Folds minutes of the day
+	/**
+	 * Rolled up candles are folded with their open, high and low. They count as minutes
+	 * of their timeframe, the mean weights them by the count
+	 *
+	 * @param iter iterator of minutes (itemTime, itemValue, itemMinutes must be available)
+	 * @return stored value, undefined when there are no minutes
+	 */
+	template<typename Iter>
+	static json::Value aggregate(Iter &iter);
+
+	static DailyRecord fromJson(const json::Value &v);
+	json::Value toJson() const {
+		return {mean, open, high, low, close, count, first, last};
+	}
+
+	///Returns true, when the stored value is the legacy format
+	static bool legacy(const json::Value &v) {return v.type() == json::number;}
+
+	///Parses name of the field (empty name is mean)
+	static std::optional<Field> parseField(std::string_view name);
+	///Returns true for fields, which are prices (can be inverted and divided)
+	static bool isPrice(Field f) {return f <= Field::close;}
+
+	double get(Field f) const;
+};
+
+template<typename Iter>
+inline json::Value DailyRecord::aggregate(Iter &iter) {
+	if (!iter.next()) return json::Value();
+	DailyRecord r;
+	double sum = 0;
+	Candle cd;
+	itemValue(iter, cd);
+	//a rolled up candle covers several minutes and it is served at the last one
+	r.first = itemTime(iter) - (itemMinutes(iter) - 1) * 60;
+	r.open = cd.o;
+	r.high = cd.h;
+	r.low = cd.l;
+	do {
+		itemValue(iter, cd);
+		std::uint64_t w = itemMinutes(iter);
+		//minutes of the candle are not known, they are estimated by its average price
+		sum += (cd.o + cd.h + cd.l + cd.c) / 4 * w;
+		r.high = std::max(r.high, cd.h);
+		r.low = std::min(r.low, cd.l);
+		r.close = cd.c;
+		r.last = itemTime(iter);
+		r.count += w;
+	} while (iter.next());
+	r.mean = sum/r.count;
+	return r.toJson();
+}
+
+inline DailyRecord DailyRecord::fromJson(const json::Value &v) {
+	DailyRecord r;
+	if (legacy(v)) {
+		r.mean = r.open = r.high = r.low = r.close = v.getNumber();
+	} else {
+		r.mean = v[0].getNumber();
+		r.open = v[1].getNumber();
+		r.high = v[2].getNumber();
+		r.low = v[3].getNumber();
+		r.close = v[4].getNumber();
+		r.count = v[5].getUInt();
+		r.first = v[6].getUInt();
+		r.last = v[7].getUInt();
+	}
+	return r;
+}
+
+inline std::optional<DailyRecord::Field> DailyRecord::parseField(std::string_view name) {
+	static const std::pair<std::string_view, Field> names[] = {
+			{"mean", Field::mean},{"open", Field::open},{"high", Field::high},{"low", Field::low},
+			{"close", Field::close},{"count", Field::count},{"first", Field::first},{"last", Field::last}
+	};
+	if (name.empty()) return Field::mean;
+	for (const auto &n: names) if (n.first == name) return n.second;
+	return std::nullopt;
+}
+
+inline double DailyRecord::get(Field f) const {
+	switch (f) {
+	case Field::open: return open;
+	case Field::high: return high;
+	case Field::low: return low;
+	case Field::close: return close;
+	case Field::count: return static_cast<double>(count);
+	case Field::first: return static_cast<double>(first);
+	case Field::last: return static_cast<double>(last);
+	default: return mean;
+	}
+}
+
+///Presents one field of the daily view as a series of prices
+/**
+ * Provides the range() interface used by iterateData()
+ */
+template<typename View>
+class DailyFieldView {
+public:
+	using BaseIterator = decltype(std::declval<View &>().range(json::Value(), json::Value()));
+
+	class Iterator {
+	public:
+		Iterator(BaseIterator &&iter, DailyRecord::Field field):iter(std::move(iter)),field(field) {}
+		bool next() {return iter.next();}
+		json::Value key() const {return iter.key();}
+		json::Value key(unsigned int index) const {return iter.key(index);}
+		json::Value value() const {return DailyRecord::fromJson(iter.value()).get(field);}
+	protected:
+		BaseIterator iter;
+		DailyRecord::Field field;
+	};
+
+	DailyFieldView(View &view, DailyRecord::Field field):view(view),field(field) {}
+
+	Iterator range(const json::Value &from, const json::Value &to) const {
+		return Iterator(view.range(from, to), field);
+	}
+
+protected:
+	View &view;
+	DailyRecord::Field field;
+};
+
+#endif /* SRC_MAIN_DAILY_RECORD_H_ */
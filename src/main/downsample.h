@@ -0,0 +1,165 @@
+/*
+ * downsample.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_DOWNSAMPLE_H_
+#define SRC_MAIN_DOWNSAMPLE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+///Computes width of a bucket
+/**
+ * @param from begin of the range
+ * @param to end of the range
+ * @param buckets required count of buckets
+ * @param align width is rounded up to multiple of this value
+ * @return width of the bucket
+ */
+inline std::uint64_t bucketWidth(std::uint64_t from, std::uint64_t to, std::uint64_t buckets, std::uint64_t align = 1) {
+	std::uint64_t range = to > from?to - from:1;
+	std::uint64_t w = (range + buckets - 1)/std::max<std::uint64_t>(buckets,1);
+	return std::max<std::uint64_t>((w + align - 1)/align*align, align);
+}
+
+///Largest-Triangle-Three-Buckets downsampler working in one pass
+/**
+ * Buckets have fixed width in time. From each bucket, the point forming the largest
+ * triangle with the previously selected point and the average of the next bucket is selected.
+ * Only points of two buckets are held in the memory. First and last point are always
+ * emitted.
+ *
+ * @tparam Out function(std::uint64_t time, double value)
+ */
+template<typename Out>
+class LTTBDownsampler {
+public:
+	///Construct downsampler
+	/**
+	 * @param from begin of the range
+	 * @param width width of the bucket
+	 * @param out output function
+	 */
+	LTTBDownsampler(std::uint64_t from, std::uint64_t width, Out &out)
+		:from(from),width(std::max<std::uint64_t>(width,1)),out(out) {}
+
+	///Adds point, points must be ordered by time
+	void push(std::uint64_t t, double v) {
+		if (!started) {
+			started = true;
+			emit(t, v);
+			return;
+		}
+		std::uint64_t b = (t > from?t - from:0)/width;
+		if (!next.empty() && b != nextBucket) {
+			selectCur();
+			std::swap(cur, next);
+			next.clear();
+		}
+		nextBucket = b;
+		next.emplace_back(t, v);
+	}
+
+	///Emits remaining points
+	void finish() {
+		if (next.empty()) return;
+		selectCur();
+		emit(next.back().first, next.back().second);
+		next.clear();
+	}
+
+protected:
+	using Point = std::pair<std::uint64_t, double>;
+
+	std::uint64_t from;
+	std::uint64_t width;
+	Out &out;
+	std::vector<Point> cur, next;
+	std::uint64_t nextBucket = 0;
+	Point last;
+	bool started = false;
+
+	void emit(std::uint64_t t, double v) {
+		last = {t, v};
+		out(t, v);
+	}
+
+	///selects point from the current bucket, next bucket must not be empty
+	void selectCur() {
+		if (cur.empty()) return;
+		double cx = 0, cy = 0;
+		for (const auto &p: next) {
+			cx += static_cast<double>(p.first);
+			cy += p.second;
+		}
+		cx /= next.size();
+		cy /= next.size();
+		double ax = static_cast<double>(last.first);
+		double ay = last.second;
+		const Point *best = &cur.front();
+		double bestArea = -1;
+		for (const auto &p: cur) {
+			double area = std::abs((ax - cx) * (p.second - ay) - (ax - static_cast<double>(p.first)) * (cy - ay));
+			if (area > bestArea) {
+				bestArea = area;
+				best = &p;
+			}
+		}
+		emit(best->first, best->second);
+		cur.clear();
+	}
+};
+
+///Downsampler emitting minimum and maximum of each bucket (in time order)
+/**
+ * @tparam Out function(std::uint64_t time, double value)
+ */
+template<typename Out>
+class MinMaxDownsampler {
+public:
+	MinMaxDownsampler(std::uint64_t from, std::uint64_t width, Out &out)
+		:from(from),width(std::max<std::uint64_t>(width,1)),out(out) {}
+
+	void push(std::uint64_t t, double v) {
+		std::uint64_t b = (t > from?t - from:0)/width;
+		if (!empty && b != bucket) finish();
+		if (empty) {
+			bucket = b;
+			mn = mx = {t, v};
+			empty = false;
+		} else {
+			if (v < mn.second) mn = {t, v};
+			if (v > mx.second) mx = {t, v};
+		}
+	}
+
+	void finish() {
+		if (empty) return;
+		if (mn.first == mx.first) {
+			out(mn.first, mn.second);
+		} else if (mn.first < mx.first) {
+			out(mn.first, mn.second);
+			out(mx.first, mx.second);
+		} else {
+			out(mx.first, mx.second);
+			out(mn.first, mn.second);
+		}
+		empty = true;
+	}
+
+protected:
+	std::uint64_t from;
+	std::uint64_t width;
+	Out &out;
+	std::pair<std::uint64_t, double> mn, mx;
+	std::uint64_t bucket = 0;
+	bool empty = true;
+};
+
+#endif /* SRC_MAIN_DOWNSAMPLE_H_ */
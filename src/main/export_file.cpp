@@ -0,0 +1,128 @@
+/*
+ * export_file.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "export_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error Export format is little endian, the writer needs a little endian host
+#endif
+
+bool ExportWriter::add(std::string_view name, Series &&minutes, Series &&daily) {
+	if (name.size() > exportfmt::maxNameLength) return false;
+	items.push_back({std::string(name), std::move(minutes), std::move(daily)});
+	return true;
+}
+
+std::uint64_t ExportWriter::write(const std::string &path) {
+	std::sort(items.begin(), items.end(), [](const Item &a, const Item &b){return a.name < b.name;});
+
+	auto align = [](std::uint64_t offset) {
+		return (offset + exportfmt::alignment - 1) / exportfmt::alignment * exportfmt::alignment;
+	};
+
+	exportfmt::Header hdr = {};
+	std::memcpy(hdr.magic, exportfmt::magic, sizeof(hdr.magic));
+	hdr.version = exportfmt::version;
+	hdr.symbols = static_cast<std::uint32_t>(items.size());
+	hdr.from = from;
+	hdr.to = to;
+	hdr.directory = sizeof(hdr);
+	hdr.created = std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+
+	//layout of the arrays
+	std::vector<exportfmt::Entry> dir(items.size());
+	std::uint64_t offset = align(hdr.directory + dir.size() * sizeof(exportfmt::Entry));
+	for (std::size_t i = 0; i < items.size(); i++) {
+		const Item &it = items[i];
+		exportfmt::Entry &e = dir[i];
+		std::memcpy(e.name, it.name.data(), it.name.size());
+		e.minuteCount = static_cast<std::uint32_t>(it.minutes.times.size());
+		e.dailyCount = static_cast<std::uint32_t>(it.daily.times.size());
+		e.minuteTimes = offset;
+		offset = align(offset + e.minuteCount * sizeof(std::uint32_t));
+		e.minutePrices = offset;
+		offset = align(offset + e.minuteCount * sizeof(double));
+		e.dailyTimes = offset;
+		offset = align(offset + e.dailyCount * sizeof(std::uint32_t));
+		e.dailyPrices = offset;
+		offset = align(offset + e.dailyCount * sizeof(double));
+	}
+
+	std::string tmp = path + ".XXXXXX";
+	int fd = mkstemp(tmp.data());
+	if (fd < 0) throw std::system_error(errno, std::generic_category(), tmp);
+	fchmod(fd, 0644);
+	close(fd);
+	std::ofstream f(tmp, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!f) {
+		int err = errno;
+		std::remove(tmp.c_str());
+		throw std::system_error(err, std::generic_category(), tmp);
+	}
+	std::uint64_t pos = 0;
+	auto put = [&](const void *data, std::size_t size) {
+		f.write(reinterpret_cast<const char *>(data), size);
+		pos += size;
+	};
+	auto pad = [&](std::uint64_t target) {
+		static const char zeroes[exportfmt::alignment] = {};
+		put(zeroes, target - pos);
+	};
+	put(&hdr, sizeof(hdr));
+	put(dir.data(), dir.size() * sizeof(exportfmt::Entry));
+	for (std::size_t i = 0; i < items.size(); i++) {
+		const Item &it = items[i];
+		const exportfmt::Entry &e = dir[i];
+		pad(e.minuteTimes);
+		put(it.minutes.times.data(), e.minuteCount * sizeof(std::uint32_t));
+		pad(e.minutePrices);
+		put(it.minutes.prices.data(), e.minuteCount * sizeof(double));
+		pad(e.dailyTimes);
+		put(it.daily.times.data(), e.dailyCount * sizeof(std::uint32_t));
+		pad(e.dailyPrices);
+		put(it.daily.prices.data(), e.dailyCount * sizeof(double));
+	}
+	pad(offset);
+	f.close();
+	if (!f) {
+		int err = errno;
+		std::remove(tmp.c_str());
+		throw std::system_error(err, std::generic_category(), tmp);
+	}
+	if (std::rename(tmp.c_str(), path.c_str())) {
+		int err = errno;
+		std::remove(tmp.c_str());
+		throw std::system_error(err, std::generic_category(), path);
+	}
+	return offset;
+}
+
+std::vector<std::string> readExportSymbols(const std::string &path) {
+	std::vector<std::string> out;
+	std::ifstream f(path, std::ios::in | std::ios::binary);
+	exportfmt::Header hdr;
+	if (!f.read(reinterpret_cast<char *>(&hdr), sizeof(hdr))) return out;
+	if (std::memcmp(hdr.magic, exportfmt::magic, sizeof(hdr.magic)) || hdr.version != exportfmt::version) return out;
+	f.seekg(hdr.directory);
+	exportfmt::Entry e;
+	for (std::uint32_t i = 0; i < hdr.symbols && f.read(reinterpret_cast<char *>(&e), sizeof(e)); i++) {
+		e.name[exportfmt::maxNameLength] = 0;
+		out.emplace_back(e.name);
+	}
+	return out;
+}
@@ -0,0 +1,123 @@
+/*
+ * export_file.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_EXPORT_FILE_H_
+#define SRC_MAIN_EXPORT_FILE_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///Memory-mappable export of prices
+/**
+ * All numbers are little endian, offsets are relative to the beginning of the file,
+ * every array starts at offset aligned to 64 bytes, so the file can be mapped and
+ * the arrays used directly.
+ *
+ * File starts with ExportHeader, which is followed by the directory of symbols (array of
+ * ExportEntry ordered by symbol name). Every entry refers four arrays: minute times (u32,
+ * unix time in seconds), minute prices (f64), daily times (u32, start of the day in seconds)
+ * and daily prices (f64, mean of the day). Prices are in usd.
+ */
+namespace exportfmt {
+
+static constexpr char magic[4] = {'M','M','P','X'};
+static constexpr std::uint32_t version = 1;
+static constexpr std::size_t alignment = 64;
+static constexpr std::size_t maxNameLength = 23;
+
+struct Header {
+	///"MMPX"
+	char magic[4];
+	///format version (1)
+	std::uint32_t version;
+	///count of symbols in the directory
+	std::uint32_t symbols;
+	std::uint32_t reserved;
+	///first time covered by the file (seconds)
+	std::uint64_t from;
+	///end of the covered range (seconds, not included)
+	std::uint64_t to;
+	///offset of the directory
+	std::uint64_t directory;
+	///time of creation (seconds)
+	std::uint64_t created;
+	std::uint8_t padding[16];
+};
+
+struct Entry {
+	///symbol, zero terminated
+	char name[maxNameLength+1];
+	std::uint32_t minuteCount;
+	std::uint32_t dailyCount;
+	std::uint64_t minuteTimes;
+	std::uint64_t minutePrices;
+	std::uint64_t dailyTimes;
+	std::uint64_t dailyPrices;
+};
+
+static_assert(sizeof(Header) == 64, "Header must have 64 bytes");
+static_assert(sizeof(Entry) == 64, "Entry must have 64 bytes");
+
+}
+
+///Collects series of symbols and writes the export file
+class ExportWriter {
+public:
+	struct Series {
+		std::vector<std::uint32_t> times;
+		std::vector<double> prices;
+	};
+
+	///Construct writer
+	/**
+	 * @param from first time covered by the file
+	 * @param to end of the covered range
+	 */
+	ExportWriter(std::uint64_t from, std::uint64_t to):from(from),to(to) {}
+
+	///Adds a symbol
+	/**
+	 * @param name name of the symbol
+	 * @param minutes minute prices
+	 * @param daily daily prices
+	 * @retval true added
+	 * @retval false name is too long
+	 */
+	bool add(std::string_view name, Series &&minutes, Series &&daily);
+
+	///Writes the file
+	/**
+	 * The file is written under a unique temporary name and renamed, so readers
+	 * never see incomplete file and concurrent writers of the same file don't collide
+	 *
+	 * @param path path of the file
+	 * @return size of the file
+	 * @exception std::system_error I/O error
+	 */
+	std::uint64_t write(const std::string &path);
+
+protected:
+	struct Item {
+		std::string name;
+		Series minutes;
+		Series daily;
+	};
+	std::uint64_t from;
+	std::uint64_t to;
+	std::vector<Item> items;
+};
+
+///Reads names of symbols from the directory of the export file
+/**
+ * @param path path of the file
+ * @return symbols, empty when the file can't be read or it is not an export
+ */
+std::vector<std::string> readExportSymbols(const std::string &path);
+
+#endif /* SRC_MAIN_EXPORT_FILE_H_ */
@@ -0,0 +1,169 @@
+/*
+ * gorilla.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "gorilla.h"
+
+#include <algorithm>
+#include <cstring>
+
+static std::uint64_t doubleBits(double v) {
+	std::uint64_t r;
+	std::memcpy(&r, &v, sizeof(r));
+	return r;
+}
+
+static double bitsDouble(std::uint64_t v) {
+	double r;
+	std::memcpy(&r, &v, sizeof(r));
+	return r;
+}
+
+void GorillaEncoder::putBits(std::uint64_t bits, unsigned int cnt) {
+	while (cnt) {
+		unsigned int take = std::min(cnt, 8U);
+		cnt -= take;
+		acc = (acc << take) | ((bits >> cnt) & ((1U << take) - 1));
+		accbits += take;
+		if (accbits >= 8) {
+			accbits -= 8;
+			data.push_back(static_cast<char>((acc >> accbits) & 0xFF));
+		}
+	}
+}
+
+void GorillaEncoder::putRaw(std::uint64_t val, unsigned int bytes) {
+	for (unsigned int i = 0; i < bytes; i++) {
+		data.push_back(static_cast<char>(val & 0xFF));
+		val >>= 8;
+	}
+}
+
+void GorillaEncoder::add(std::uint64_t time, double price) {
+	std::uint64_t bits = doubleBits(price);
+	if (count == 0) {
+		data.assign(4,0);
+		putRaw(time, 8);
+		putRaw(bits, 8);
+		prevDelta = 0;
+		prevLeading = 0xFF;
+	} else {
+		std::int64_t delta = static_cast<std::int64_t>(time - prevTime);
+		std::int64_t dod = delta - prevDelta;
+		if (dod == 0) {
+			putBits(0,1);
+		} else if (dod >= -63 && dod <= 64) {
+			putBits(0x2, 2);
+			putBits(dod+63, 7);
+		} else if (dod >= -255 && dod <= 256) {
+			putBits(0x6, 3);
+			putBits(dod+255, 9);
+		} else if (dod >= -2047 && dod <= 2048) {
+			putBits(0xE, 4);
+			putBits(dod+2047, 12);
+		} else {
+			putBits(0xF, 4);
+			putBits(static_cast<std::uint64_t>(dod), 64);
+		}
+		prevDelta = delta;
+
+		std::uint64_t x = bits ^ prevBits;
+		if (x == 0) {
+			putBits(0,1);
+		} else {
+			unsigned int leading = std::min(__builtin_clzll(x), 31);
+			unsigned int trailing = __builtin_ctzll(x);
+			if (prevLeading != 0xFF && leading >= prevLeading && trailing >= prevTrailing) {
+				putBits(0x2, 2);
+				putBits(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+			} else {
+				unsigned int significant = 64 - leading - trailing;
+				putBits(0x3, 2);
+				putBits(leading, 5);
+				putBits(significant & 0x3F, 6);
+				putBits(x >> trailing, significant);
+				prevLeading = leading;
+				prevTrailing = trailing;
+			}
+		}
+	}
+	prevTime = time;
+	prevBits = bits;
+	count++;
+}
+
+std::string GorillaEncoder::finish() {
+	if (accbits) {
+		putBits(0, 8 - accbits);
+	}
+	for (unsigned int i = 0; i < 4 && i < data.size(); i++) {
+		data[i] = static_cast<char>((count >> (i * 8)) & 0xFF);
+	}
+	std::string out = std::move(data);
+	data.clear();
+	acc = 0;
+	accbits = 0;
+	count = 0;
+	return out;
+}
+
+GorillaDecoder::GorillaDecoder(std::string_view data):data(data) {
+	count = static_cast<std::uint32_t>(getRaw(4));
+}
+
+std::uint64_t GorillaDecoder::getRaw(unsigned int bytes) {
+	std::uint64_t r = 0;
+	for (unsigned int i = 0; i < bytes && pos < data.size(); i++) {
+		r |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos++])) << (i * 8);
+	}
+	return r;
+}
+
+std::uint64_t GorillaDecoder::getBits(unsigned int cnt) {
+	std::uint64_t r = 0;
+	while (cnt) {
+		if (accbits == 0) {
+			acc = pos < data.size()?static_cast<unsigned char>(data[pos++]):0;
+			accbits = 8;
+		}
+		unsigned int take = std::min(cnt, accbits);
+		accbits -= take;
+		cnt -= take;
+		r = (r << take) | ((acc >> accbits) & ((1U << take) - 1));
+	}
+	return r;
+}
+
+bool GorillaDecoder::next() {
+	if (index >= count) return false;
+	if (index == 0) {
+		time = getRaw(8);
+		prevBits = getRaw(8);
+		prevDelta = 0;
+	} else {
+		std::int64_t dod;
+		if (!getBit()) dod = 0;
+		else if (!getBit()) dod = static_cast<std::int64_t>(getBits(7)) - 63;
+		else if (!getBit()) dod = static_cast<std::int64_t>(getBits(9)) - 255;
+		else if (!getBit()) dod = static_cast<std::int64_t>(getBits(12)) - 2047;
+		else dod = static_cast<std::int64_t>(getBits(64));
+		prevDelta += dod;
+		time += prevDelta;
+
+		if (getBit()) {
+			if (getBit()) {
+				prevLeading = static_cast<unsigned int>(getBits(5));
+				unsigned int significant = static_cast<unsigned int>(getBits(6));
+				if (significant == 0) significant = 64;
+				prevTrailing = 64 - prevLeading - significant;
+			}
+			prevBits ^= getBits(64 - prevLeading - prevTrailing) << prevTrailing;
+		}
+	}
+	price = bitsDouble(prevBits);
+	index++;
+	return true;
+}
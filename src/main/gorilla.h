@@ -0,0 +1,87 @@
+/*
+ * gorilla.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_GORILLA_H_
+#define SRC_MAIN_GORILLA_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+///Compresses series of (time, price) pairs
+/**
+ * Times are stored as delta-of-delta, prices are stored as XOR with the previous
+ * price (Gorilla encoding). Minute data collected regularly need 1 bit per time and
+ * few bits per price, which are often same as previous price.
+ *
+ * Format: u32 count (little endian), u64 first time, u64 first price, then bit stream
+ */
+class GorillaEncoder {
+public:
+
+	///Appends next pair. Times must be ascending
+	void add(std::uint64_t time, double price);
+
+	///Finishes block and returns encoded data. Encoder is reset
+	std::string finish();
+
+	///Count of pairs in the block
+	std::uint32_t size() const {return count;}
+
+protected:
+	std::string data;
+	std::uint64_t acc = 0;
+	unsigned int accbits = 0;
+	std::uint32_t count = 0;
+
+	std::uint64_t prevTime = 0;
+	std::int64_t prevDelta = 0;
+	std::uint64_t prevBits = 0;
+	unsigned int prevLeading = 0xFF;
+	unsigned int prevTrailing = 0;
+
+	void putBits(std::uint64_t bits, unsigned int count);
+	void putRaw(std::uint64_t val, unsigned int bytes);
+};
+
+///Decodes block created by GorillaEncoder
+class GorillaDecoder {
+public:
+	GorillaDecoder(std::string_view data = std::string_view());
+
+	///Decodes next pair
+	/**
+	 * @retval true decoded, use time and price
+	 * @retval false no more data
+	 */
+	bool next();
+
+	///Count of pairs in the block
+	std::uint32_t size() const {return count;}
+
+	std::uint64_t time = 0;
+	double price = 0;
+
+protected:
+	std::string_view data;
+	std::size_t pos = 0;
+	std::uint64_t acc = 0;
+	unsigned int accbits = 0;
+	std::uint32_t count = 0;
+	std::uint32_t index = 0;
+
+	std::int64_t prevDelta = 0;
+	std::uint64_t prevBits = 0;
+	unsigned int prevLeading = 0;
+	unsigned int prevTrailing = 0;
+
+	std::uint64_t getBits(unsigned int count);
+	bool getBit() {return getBits(1) != 0;}
+	std::uint64_t getRaw(unsigned int bytes);
+};
+
+#endif /* SRC_MAIN_GORILLA_H_ */
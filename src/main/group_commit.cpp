@@ -0,0 +1,105 @@
+/*
+ * group_commit.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "group_commit.h"
+
+#include <vector>
+
+using namespace docdb;
+
+GroupCommit::GroupCommit(DB &db, std::chrono::microseconds maxLatency, std::size_t maxBytes, Metrics &metrics)
+	:db(db),maxLatency(maxLatency),maxBytes(maxBytes)
+	,groupBytes(metrics.histogram("commit_group_bytes", "", 1))
+	,groupBatches(metrics.histogram("commit_group_batches", "", 1))
+	,writeTime(metrics.histogram("commit_write_seconds", ""))
+	,commitTime(metrics.histogram("commit_latency_seconds", ""))
+	,thr([this]{worker();}) {}
+
+GroupCommit::~GroupCommit() {
+	{
+		std::lock_guard _(lock);
+		stopping = true;
+	}
+	submitted.notify_all();
+	thr.join();
+}
+
+void GroupCommit::commit(Batch &batch) {
+	commit(batch, nullptr);
+}
+
+void GroupCommit::commit(Batch &batch, const std::function<void(Batch &)> &prepare) {
+	auto start = std::chrono::steady_clock::now();
+	Pending p{&batch, batch.ApproximateSize(), prepare?&prepare:nullptr};
+	std::unique_lock lk(lock);
+	queue.push_back(&p);
+	queueBytes += p.size;
+	submitted.notify_all();
+	written.wait(lk, [&]{return p.done;});
+	lk.unlock();
+	commitTime.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	if (p.err) std::rethrow_exception(p.err);
+}
+
+void GroupCommit::worker() {
+	std::vector<Pending *> group;
+	Batch merged;
+	std::unique_lock lk(lock);
+	for (;;) {
+		submitted.wait(lk, [&]{return stopping || !queue.empty();});
+		if (queue.empty()) break;
+		//single writer is written immediately, the latency is spent only when other
+		//writers are active (batches queued during the previous write), unless the group is full
+		if (queue.size() > 1) {
+			auto deadline = std::chrono::steady_clock::now() + maxLatency;
+			while (!stopping && queueBytes < maxBytes
+					&& submitted.wait_until(lk, deadline) != std::cv_status::timeout) {}
+		}
+
+		std::size_t bytes = 0;
+		do {
+			Pending *p = queue.front();
+			if (!group.empty() && (p->prepare || bytes + p->size > maxBytes)) break;
+			queue.pop_front();
+			queueBytes -= p->size;
+			bytes += p->size;
+			group.push_back(p);
+			//prepared batch is written alone
+			if (p->prepare) break;
+		} while (!queue.empty());
+		lk.unlock();
+
+		std::exception_ptr err;
+		auto start = std::chrono::steady_clock::now();
+		try {
+			if (group.size() == 1) {
+				if (group[0]->prepare) (*group[0]->prepare)(*group[0]->batch);
+				db.commitBatch(*group[0]->batch);
+			} else {
+				for (Pending *p: group) merged.Append(*p->batch);
+				db.commitBatch(merged);
+				merged.Clear();
+			}
+		} catch (...) {
+			err = std::current_exception();
+			merged.Clear();
+		}
+		writeTime.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+		groupBytes.record(bytes);
+		groupBatches.record(group.size());
+		writeCount++;
+		batchCount += group.size();
+
+		lk.lock();
+		for (Pending *p: group) {
+			p->err = err;
+			p->done = true;
+		}
+		group.clear();
+		written.notify_all();
+	}
+}
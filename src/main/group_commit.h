@@ -0,0 +1,106 @@
+/*
+ * group_commit.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_GROUP_COMMIT_H_
+#define SRC_MAIN_GROUP_COMMIT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "../docdb/src/docdblib/db.h"
+#include "metrics.h"
+
+///Merges batches of concurrent writers into single writes
+/**
+ * Writers (collector, imports, jobs) submit batches by commit(). A writer thread
+ * writes a lone batch immediately. Batches submitted while a write is in progress
+ * wait for it and form the next group, which also collects batches arrived within
+ * maxLatency (or until maxBytes is reached). The group is written as one batch, so
+ * the WAL sync and update of the views is paid once per group. Batches are written
+ * in the order of submission, commit() returns when the batch is written.
+ */
+class GroupCommit {
+public:
+
+	///Construct writer
+	/**
+	 * @param db database
+	 * @param maxLatency how long a group waits for other batches (only when more batches are waiting)
+	 * @param maxBytes max size of a group (a larger batch is written alone)
+	 * @param metrics registry of metrics
+	 */
+	GroupCommit(docdb::DB &db, std::chrono::microseconds maxLatency, std::size_t maxBytes, Metrics &metrics);
+	///Writes pending batches and stops the writer thread
+	~GroupCommit();
+
+	///Commits the batch
+	/**
+	 * Blocks until the batch is written. Batch is not cleared (same as DB::commitBatch).
+	 * Exception thrown by the write is rethrown to all writers of the group
+	 */
+	void commit(docdb::Batch &batch);
+
+	///Completes the batch on the writer thread and commits it
+	/**
+	 * The prepare function is called right before the batch is written, when all
+	 * previously submitted batches are written and no other write can run. The batch is
+	 * written alone. Use it to make changes depending on the current content of the database
+	 * (erase a key, only if it has not been changed by a concurrent writer)
+	 *
+	 * @param batch batch
+	 * @param prepare function called with the batch
+	 */
+	void commit(docdb::Batch &batch, const std::function<void(docdb::Batch &)> &prepare);
+
+	///Count of writes to the database
+	std::uint64_t writes() const {return writeCount;}
+	///Count of committed batches
+	std::uint64_t batches() const {return batchCount;}
+
+protected:
+
+	struct Pending {
+		docdb::Batch *batch;
+		std::size_t size;
+		const std::function<void(docdb::Batch &)> *prepare = nullptr;
+		bool done = false;
+		std::exception_ptr err;
+	};
+
+	docdb::DB &db;
+	std::chrono::microseconds maxLatency;
+	std::size_t maxBytes;
+	///size of a written group in bytes
+	Histogram &groupBytes;
+	///count of batches in a written group
+	Histogram &groupBatches;
+	///duration of the write
+	Histogram &writeTime;
+	///time from submission to the end of the write
+	Histogram &commitTime;
+
+	std::mutex lock;
+	std::condition_variable submitted;
+	std::condition_variable written;
+	std::deque<Pending *> queue;
+	std::size_t queueBytes = 0;
+	bool stopping = false;
+	std::atomic<std::uint64_t> writeCount = 0;
+	std::atomic<std::uint64_t> batchCount = 0;
+	std::thread thr;
+
+	void worker();
+};
+
+#endif /* SRC_MAIN_GROUP_COMMIT_H_ */
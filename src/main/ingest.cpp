@@ -0,0 +1,127 @@
+/*
+ * ingest.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "ingest.h"
+
+#include <algorithm>
+#include <atomic>
+
+static std::atomic<std::uint64_t> instanceCounter(0);
+
+IngestPipeline::IngestPipeline():instance(++instanceCounter) {}
+
+IngestPipeline::Accum &IngestPipeline::Buffer::get(SymbolId id) {
+	if (id >= acc.size()) acc.resize(id+1);
+	Accum &a = acc[id];
+	if (a.empty()) touched.push_back(id);
+	return a;
+}
+
+IngestPipeline::Buffer &IngestPipeline::local() {
+	//buffer of current thread, instance detects destroyed pipeline
+	static thread_local std::uint64_t tlsInstance = 0;
+	static thread_local Buffer *tlsBuffer = nullptr;
+	if (tlsInstance != instance) {
+		std::lock_guard _(bufferLock);
+		buffers.push_back(std::make_unique<Buffer>());
+		tlsBuffer = buffers.back().get();
+		tlsInstance = instance;
+	}
+	return *tlsBuffer;
+}
+
+IngestPipeline::SymbolId IngestPipeline::globalIntern(std::string_view symbol) {
+	{
+		std::shared_lock _(symbolLock);
+		auto iter = symbolIds.find(symbol);
+		if (iter != symbolIds.end()) return iter->second;
+	}
+	std::unique_lock _(symbolLock);
+	auto iter = symbolIds.find(symbol);
+	if (iter != symbolIds.end()) return iter->second;
+	SymbolId id = static_cast<SymbolId>(symbolNames.size());
+	symbolNames.emplace_back(symbol);
+	symbolIds.emplace(symbolNames.back(), id);
+	return id;
+}
+
+IngestPipeline::SymbolId IngestPipeline::intern(std::string_view symbol) {
+	Buffer &buff = local();
+	//cache is accessed only by the owning thread
+	auto iter = buff.cache.find(symbol);
+	if (iter != buff.cache.end()) return iter->second;
+	SymbolId id = globalIntern(symbol);
+	buff.cache.emplace(std::string(symbol), id);
+	return id;
+}
+
+std::string IngestPipeline::name(SymbolId id) const {
+	std::shared_lock _(symbolLock);
+	return symbolNames[id];
+}
+
+void IngestPipeline::add(SymbolId id, double price) {
+	Buffer &buff = local();
+	std::lock_guard _(buff.lock);
+	Accum &a = buff.get(id);
+	a.sum += price;
+	a.count++;
+}
+
+void IngestPipeline::addFallback(SymbolId id, double price) {
+	Buffer &buff = local();
+	std::lock_guard _(buff.lock);
+	buff.get(id).fallback = price;
+}
+
+void IngestPipeline::mergeBuffers() {
+	std::vector<Buffer *> bufs;
+	{
+		std::lock_guard _(bufferLock);
+		for (const auto &b: buffers) bufs.push_back(b.get());
+	}
+	for (Buffer *b: bufs) {
+		std::lock_guard _(b->lock);
+		for (SymbolId id: b->touched) {
+			Accum &src = b->acc[id];
+			if (id >= minute.size()) minute.resize(id+1);
+			Accum &trg = minute[id];
+			trg.sum += src.sum;
+			trg.count += src.count;
+			if (src.fallback) trg.fallback = src.fallback;
+			src = Accum();
+		}
+		b->touched.clear();
+	}
+}
+
+IngestPipeline::Result IngestPipeline::commit(std::uint64_t time) {
+	std::lock_guard _(commitLock);
+	if (time != minuteTime) {
+		minute.clear();
+		minuteTime = time;
+	}
+	mergeBuffers();
+	Result out;
+	{
+		std::shared_lock _(symbolLock);
+		for (SymbolId id = 0; id < minute.size(); id++) {
+			const Accum &a = minute[id];
+			if (a.count) out.emplace_back(symbolNames[id], a.sum/a.count);
+			else if (a.fallback) out.emplace_back(symbolNames[id], a.fallback);
+		}
+	}
+	std::sort(out.begin(), out.end(), [](const auto &a, const auto &b){return a.first < b.first;});
+	return out;
+}
+
+void IngestPipeline::clear() {
+	std::lock_guard _(commitLock);
+	mergeBuffers();
+	minute.clear();
+	minuteTime = 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * ingest.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_INGEST_H_
+#define SRC_MAIN_INGEST_H_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///Collects prices from collectors until commit
+/**
+ * Each thread accumulates prices into own buffer, so collectors running in parallel
+ * don't block each other. Symbols are interned to integer ids, the buffer is
+ * a plain array indexed by the id. Buffers are merged only at commit.
+ *
+ * Sums of the current minute are kept between commits, so commit can be called
+ * more often than once per minute, each commit stores average of all prices
+ * collected during the minute so far.
+ */
+class IngestPipeline {
+public:
+
+	using SymbolId = std::uint32_t;
+	///Committed prices, ordered by symbol
+	using Result = std::vector<std::pair<std::string, double> >;
+
+	IngestPipeline();
+
+	///Returns id of the symbol (allocates new id for unknown symbol)
+	SymbolId intern(std::string_view symbol);
+	///Returns name of the symbol
+	std::string name(SymbolId id) const;
+
+	///Adds price
+	void add(SymbolId id, double price);
+	void add(std::string_view symbol, double price) {add(intern(symbol), price);}
+	///Adds fallback price - used only when no other source has the symbol
+	void addFallback(SymbolId id, double price);
+	void addFallback(std::string_view symbol, double price) {addFallback(intern(symbol), price);}
+
+	///Merges all buffers and returns prices of the minute
+	/**
+	 * @param time time of the commit (whole minute). When differs from the previous commit,
+	 * sums of the previous minute are dropped
+	 * @return prices, ordered by symbol
+	 */
+	Result commit(std::uint64_t time);
+	///Drops all collected prices
+	void clear();
+
+protected:
+
+	struct Accum {
+		double sum = 0;
+		std::uint32_t count = 0;
+		double fallback = 0;
+
+		bool empty() const {return count == 0 && fallback == 0;}
+	};
+
+	struct Buffer {
+		std::mutex lock;
+		std::vector<Accum> acc;
+		std::vector<SymbolId> touched;
+		std::map<std::string, SymbolId, std::less<> > cache;
+
+		Accum &get(SymbolId id);
+	};
+
+	mutable std::shared_mutex symbolLock;
+	std::map<std::string, SymbolId, std::less<> > symbolIds;
+	std::deque<std::string> symbolNames;
+
+	std::mutex bufferLock;
+	std::vector<std::unique_ptr<Buffer> > buffers;
+
+	std::mutex commitLock;
+	std::vector<Accum> minute;
+	std::uint64_t minuteTime = 0;
+
+	std::uint64_t instance;
+
+	Buffer &local();
+	SymbolId globalIntern(std::string_view symbol);
+	void mergeBuffers();
+};
+
+#endif /* SRC_MAIN_INGEST_H_ */
@@ -0,0 +1,360 @@
+/*
+ * iterate_data.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_ITERATE_DATA_H_
+#define SRC_MAIN_ITERATE_DATA_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "candle.h"
+#include "merge_join.h"
+#include "parallel_scan.h"
+
+///Enumerates prices of a pair
+/**
+ * @param pmap source of prices (minute map, price store, daily view)
+ * @param asset asset
+ * @param currency currency
+ * @param from first time (in units of the source)
+ * @param to end time, 0 - no limit
+ * @param timeMult multiplier of time of the source to get seconds
+ * @param fillForward cross pairs: fill missing values with last known price
+ * @param out function(std::uint64_t time, double price)
+ */
+template<typename Source, typename Fn>
+inline void iterateData(Source &pmap, std::string_view asset, std::string_view currency, std::uint64_t from, std::uint64_t to, std::uint64_t timeMult, bool fillForward, Fn &&out) {
+	if (to == 0) --to;
+	if (asset == "usd") {
+		auto iter1 = pmap.range({currency, from},{currency, to});
+		while (iter1.next()) {
+			auto t1 = itemTime(iter1);
+			double v1 = itemPrice(iter1);
+			out(t1*timeMult, 1.0/v1);
+		}
+	} else if (currency == "usd") {
+		auto iter1 = pmap.range({asset, from},{asset, to});
+		while (iter1.next()) {
+			auto t1 = itemTime(iter1);
+			double v1 = itemPrice(iter1);
+			out(t1*timeMult, v1);
+		}
+	} else {
+		mergeJoin(from, [&](std::uint64_t f){
+			return pmap.range({asset, f},{asset, to});
+		}, [&](std::uint64_t f){
+			return pmap.range({currency, f},{currency, to});
+		}, fillForward, [&](std::uint64_t t, double v1, double v2){
+			out(t*timeMult, v1/v2);
+		});
+	}
+}
+
+///Opens range of one series of the source at given time (see MergeJoin)
+template<typename Source>
+struct SeriesOpen {
+	Source *pmap;
+	std::string_view symbol;
+	std::uint64_t to;
+	auto operator()(std::uint64_t f) const {return pmap->range({symbol, f},{symbol, to});}
+};
+
+///Inverts a candle (usd/currency), high and low are swapped
+inline Candle invertCandle(const Candle &cd) {
+	return {cd.t, 1.0/cd.o, 1.0/cd.l, 1.0/cd.h, 1.0/cd.c};
+}
+
+///Candle of a cross pair from candles of both series at the same time
+/**
+ * Open and close are exact. High and low of the cross are not known for rolled up
+ * candles, they are bounded by high/low and low/high of the series (exact for minutes)
+ */
+inline Candle crossCandle(std::uint64_t t, const Candle &a, const Candle &b) {
+	return {t, a.o/b.o, a.h/b.l, a.l/b.h, a.c/b.c};
+}
+
+///Folds prices of a pair to candles
+/**
+ * Prices are folded one at a time, as they come from the iterator. Staging them to runs
+ * for the vector kernels (src/bench/kernels.h) is slower end-to-end (see bench_kernels).
+ * Rolled up candles of the source are folded with their open, high and low
+ *
+ * @param pmap source of minute prices
+ * @param asset asset
+ * @param currency currency
+ * @param from first time
+ * @param to end time, 0 - no limit
+ * @param tfrm timeframe in seconds
+ * @param fillForward cross pairs: fill missing values with last known price
+ * @param out function(const Candle &)
+ */
+template<typename Source, typename Fn>
+inline void iterateCandles(Source &pmap, std::string_view asset, std::string_view currency, std::uint64_t from, std::uint64_t to, std::uint64_t tfrm, bool fillForward, Fn &&out) {
+	Candle cd{};
+	bool any = false;
+	auto add = [&](const Candle &x) {
+		std::uint64_t frame = x.t/tfrm*tfrm;
+		if (!any || cd.t != frame) {
+			if (any) out(cd);
+			cd = {frame, x.o, x.h, x.l, x.c};
+			any = true;
+		} else {
+			cd.h = std::max(cd.h, x.h);
+			cd.l = std::min(cd.l, x.l);
+			cd.c = x.c;
+		}
+	};
+	if (to == 0) --to;
+	Candle x;
+	if (asset == "usd") {
+		auto iter = pmap.range({currency, from},{currency, to});
+		while (iter.next()) {
+			itemValue(iter, x);
+			add(invertCandle(x));
+		}
+	} else if (currency == "usd") {
+		auto iter = pmap.range({asset, from},{asset, to});
+		while (iter.next()) {
+			itemValue(iter, x);
+			add(x);
+		}
+	} else {
+		MergeJoin<SeriesOpen<Source>, SeriesOpen<Source>, Candle> join(from,
+				SeriesOpen<Source>{&pmap, asset, to}, SeriesOpen<Source>{&pmap, currency, to}, fillForward);
+		while (join.read(std::numeric_limits<std::size_t>::max(), [&](std::uint64_t t, const Candle &a, const Candle &b) {
+			add(crossCandle(t, a, b));
+		}));
+	}
+	if (any) out(cd);
+}
+
+///Finds the first time of a pair
+/**
+ * @param pmap source of prices
+ * @param asset asset
+ * @param currency currency
+ * @param from first time
+ * @param to end time, 0 - no limit
+ * @param first receives time, before which the pair has no data (at least from)
+ * @retval true found
+ * @retval false one of the series has no data in the range
+ */
+template<typename Source>
+inline bool firstPairTime(Source &pmap, std::string_view asset, std::string_view currency, std::uint64_t from, std::uint64_t to, std::uint64_t &first) {
+	std::uint64_t limit = to?to:std::numeric_limits<std::uint64_t>::max();
+	first = from;
+	for (std::string_view symbol: {asset, currency}) {
+		if (symbol == "usd") continue;
+		auto iter = pmap.range({symbol, from},{symbol, limit});
+		if (!iter.next()) return false;
+		first = std::max(first, itemTime(iter));
+	}
+	return true;
+}
+
+///Reads minute prices of a pair in parallel shards
+/**
+ * Range is split into shards aligned to the shard size of the scanner. Shards are read
+ * concurrently, every shard reads both series of a cross pair, so it produces the same
+ * items as the sequential join (without fill forward)
+ *
+ * @tparam T type of item produced by the shard
+ * @param scan scanner
+ * @param pmap source of minute prices
+ * @param asset asset
+ * @param currency currency
+ * @param from first time
+ * @param to end time, 0 - no limit
+ * @param produce function(std::uint64_t from, std::uint64_t to, std::vector<T> &items) - reads one shard
+ * @param consume function(std::vector<T> &items) - called for every shard in order
+ * @retval true done
+ * @retval false range is too short to be split or parallel scan is disabled, nothing has
+ *  been read, caller should read the range sequentially
+ */
+template<typename T, typename Source, typename Produce, typename Consume>
+inline bool iterateShards(const ParallelScan &scan, Source &pmap, std::string_view asset, std::string_view currency,
+		std::uint64_t from, std::uint64_t to, Produce &&produce, Consume &&consume) {
+	if (scan.getParallel() < 2) return false;
+	std::uint64_t shard = scan.getShardSize();
+	std::uint64_t end = to?to:std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count()+1;
+	if (end <= from || end - from < 2*shard) return false;
+	//skip empty head of the range (series starts later than requested)
+	std::uint64_t begin;
+	if (!firstPairTime(pmap, asset, currency, from, to, begin)) return false;
+	if (end <= begin || end - begin < 2*shard) return false;
+	std::vector<std::pair<std::uint64_t, std::uint64_t> > shards;
+	for (std::uint64_t b = begin; b < end;) {
+		std::uint64_t e = (b/shard+1)*shard;
+		if (e >= end) e = to;
+		shards.emplace_back(b, e);
+		if (e == to) break;
+		b = e;
+	}
+	scan.run<T>(shards.size(), [&](std::size_t i, std::vector<T> &items) {
+		produce(shards[i].first, shards[i].second, items);
+	}, consume);
+	return true;
+}
+
+///Enumerates prices of a pair, long minute ranges are read in parallel shards
+/**
+ * Same as iterateData(). Only minute sources (timeMult == 1) are split. Cross pairs
+ * with fill forward are read sequentially, because a shard doesn't know last prices
+ * of the previous shard
+ */
+template<typename Source, typename Fn>
+inline void iterateDataParallel(const ParallelScan &scan, Source &pmap, std::string_view asset, std::string_view currency, std::uint64_t from, std::uint64_t to, std::uint64_t timeMult, bool fillForward, Fn &&out) {
+	using Item = std::pair<std::uint64_t, double>;
+	bool cross = asset != "usd" && currency != "usd";
+	if (timeMult == 1 && !(cross && fillForward) && iterateShards<Item>(scan, pmap, asset, currency, from, to,
+			[&](std::uint64_t f, std::uint64_t t, std::vector<Item> &items) {
+				iterateData(pmap, asset, currency, f, t, 1, false, [&](std::uint64_t tm, double v) {
+					items.emplace_back(tm, v);
+				});
+			}, [&](std::vector<Item> &items) {
+				for (const auto &x: items) out(x.first, x.second);
+			})) return;
+	iterateData(pmap, asset, currency, from, to, timeMult, fillForward, out);
+}
+
+///Splits a range of a pair to slices, which are read by consecutive steps
+/**
+ * The slice covers all threads of the scanner (parallel × shard), so long ranges are still
+ * read in parallel shards. Slices are aligned to multiples of its size, empty parts of
+ * the range are skipped
+ */
+class RangeSlices {
+public:
+	///Construct slices
+	/**
+	 * @param scan scanner
+	 * @param from first time (in units of the source)
+	 * @param to end time, 0 - no limit
+	 * @param timeMult multiplier of time of the source to get seconds
+	 */
+	RangeSlices(const ParallelScan &scan, std::uint64_t from, std::uint64_t to, std::uint64_t timeMult)
+		:cur(from),to(to),timeMult(timeMult)
+		,size(std::max<std::uint64_t>(1, scan.getShardSize()*scan.getParallel()/timeMult)) {}
+
+	///Returns next slice
+	/**
+	 * @param pmap source of prices
+	 * @param asset asset
+	 * @param currency currency
+	 * @param from receives first time of the slice
+	 * @param to receives end time of the slice, 0 - no limit (the last slice of open range)
+	 * @retval true slice returned
+	 * @retval false range is complete
+	 */
+	template<typename Source>
+	bool next(Source &pmap, std::string_view asset, std::string_view currency, std::uint64_t &from, std::uint64_t &to) {
+		if (done || !firstPairTime(pmap, asset, currency, cur, this->to, cur)) {
+			done = true;
+			return false;
+		}
+		std::uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count()/timeMult;
+		std::uint64_t e = (cur/size+1)*size;
+		if (this->to?e >= this->to:e > now) {
+			//last slice, open range stays open
+			e = this->to;
+			done = true;
+		}
+		from = cur;
+		to = e;
+		cur = e;
+		return true;
+	}
+
+	///Returns true, when the last slice has been returned
+	bool last() const {return done;}
+
+protected:
+	std::uint64_t cur;
+	std::uint64_t to;
+	std::uint64_t timeMult;
+	std::uint64_t size;
+	bool done = false;
+};
+
+///Enumerates prices of a pair in parts
+/**
+ * Same items as iterateDataParallel(), but the range is read by consecutive calls
+ * of read(), so the consumer can be suspended between them. Every call reads one slice
+ * of the range (see RangeSlices). Cross pairs with fill forward are read by a resumable
+ * join, because a slice doesn't know last prices of the previous slice.
+ *
+ * The object must not be moved after the first read()
+ *
+ * @tparam Source source of prices (minute map, price store, daily view)
+ */
+template<typename Source>
+class PairReader {
+public:
+	///Count of items of the join read by one call (cross pairs with fill forward)
+	static constexpr std::size_t joinItems = 16384;
+
+	///Construct reader
+	/**
+	 * Parameters are same as iterateDataParallel()
+	 */
+	PairReader(const ParallelScan &scan, Source &pmap, std::string asset, std::string currency,
+			std::uint64_t from, std::uint64_t to, std::uint64_t timeMult, bool fillForward)
+		:scan(scan),pmap(pmap),asset(std::move(asset)),currency(std::move(currency))
+		,from(from),to(to),timeMult(timeMult),fillForward(fillForward),slices(scan, from, to, timeMult) {}
+
+	///Reads next part
+	/**
+	 * @param out function(std::uint64_t time, double price)
+	 * @retval true more data can follow
+	 * @retval false range is complete
+	 */
+	template<typename Fn>
+	bool read(Fn &&out);
+
+protected:
+	using Open = SeriesOpen<Source>;
+
+	const ParallelScan &scan;
+	Source &pmap;
+	std::string asset;
+	std::string currency;
+	std::uint64_t from;
+	std::uint64_t to;
+	std::uint64_t timeMult;
+	bool fillForward;
+	RangeSlices slices;
+	std::optional<MergeJoin<Open, Open> > join;
+};
+
+template<typename Source>
+template<typename Fn>
+inline bool PairReader<Source>::read(Fn &&out) {
+	if (fillForward && asset != "usd" && currency != "usd") {
+		if (!join) {
+			std::uint64_t end = to?to:std::numeric_limits<std::uint64_t>::max();
+			join.emplace(from, Open{&pmap, asset, end}, Open{&pmap, currency, end}, true);
+		}
+		return join->read(joinItems, [&](std::uint64_t t, double v1, double v2){
+			out(t*timeMult, v1/v2);
+		});
+	}
+	std::uint64_t f, t;
+	if (!slices.next(pmap, asset, currency, f, t)) return false;
+	iterateDataParallel(scan, pmap, asset, currency, f, t, timeMult, fillForward, out);
+	return !slices.last();
+}
+
+#endif /* SRC_MAIN_ITERATE_DATA_H_ */
@@ -0,0 +1,169 @@
+/*
+ * jobs.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "jobs.h"
+
+#include <imtjson/object.h>
+#include <imtjson/array.h>
+#include "../shared/logOutput.h"
+
+void RateLimiter::acquire(std::size_t ops) {
+	if (rate == 0) return;
+	double wait;
+	{
+		std::lock_guard _(lock);
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - last).count();
+		last = now;
+		tokens = std::min<double>(tokens + elapsed * rate, rate);
+		tokens -= ops;
+		wait = tokens < 0?-tokens/rate:0;
+	}
+	if (wait > 0) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+	}
+}
+
+void JobContext::throttle(std::size_t ops) {
+	owner.getLimiter().acquire(ops);
+}
+
+JobManager::JobManager(unsigned int threads, std::size_t ioRate):limiter(ioRate) {
+	for (unsigned int i = 0; i < std::max(threads, 1U); i++) {
+		workers.emplace_back([this]{worker();});
+	}
+}
+
+JobManager::~JobManager() {
+	{
+		std::lock_guard _(lock);
+		stopping = true;
+		for (auto &j: jobs) j.second->cancelFlag = true;
+	}
+	cond.notify_all();
+	for (auto &t: workers) t.join();
+}
+
+std::uint64_t JobManager::start(std::string type, std::vector<std::string> shards, WorkFn work, FinishFn finish) {
+	auto job = std::make_shared<Job>();
+	job->type = std::move(type);
+	job->work = std::move(work);
+	job->finish = std::move(finish);
+	job->total = shards.size();
+	job->started = std::chrono::system_clock::now();
+	std::uint64_t id;
+	{
+		std::lock_guard _(lock);
+		id = job->id = nextId++;
+		jobs.emplace(id, job);
+		for (auto &s: shards) queue.emplace_back(job, std::move(s));
+		cleanup();
+	}
+	ondra_shared::logNote("Job #$1 ($2) started, shards: $3", id, job->type, job->total);
+	if (shards.empty()) {
+		job->finished = std::chrono::system_clock::now();
+		if (job->finish) job->finish();
+	}
+	cond.notify_all();
+	return id;
+}
+
+void JobManager::worker() {
+	std::unique_lock lk(lock);
+	while (true) {
+		cond.wait(lk, [&]{return stopping || !queue.empty();});
+		if (stopping) break;
+		auto [job, shard] = std::move(queue.front());
+		queue.pop_front();
+		lk.unlock();
+
+		json::Value res;
+		std::string error;
+		if (!job->cancelFlag) {
+			try {
+				JobContext ctx(*this, job->cancelFlag);
+				res = job->work(ctx, shard);
+			} catch (std::exception &e) {
+				error = e.what();
+				ondra_shared::logError("Job #$1 ($2), shard $3 failed: $4", job->id, job->type, shard, error);
+			}
+		}
+
+		lk.lock();
+		if (!error.empty()) job->error = error;
+		if (res.defined()) job->results.emplace(shard, res);
+		bool finished = ++job->done == job->total;
+		if (finished) {
+			job->finished = std::chrono::system_clock::now();
+			ondra_shared::logNote("Job #$1 ($2) $3", job->id, job->type, job->cancelFlag?"cancelled":"finished");
+			if (job->finish) {
+				lk.unlock();
+				job->finish();
+				lk.lock();
+			}
+		}
+	}
+}
+
+json::Value JobManager::jobStatus(const Job &job, bool withResult) const {
+	auto unixTime = [](std::chrono::system_clock::time_point tp) {
+		return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+	};
+	const char *state = job.done < job.total?(job.cancelFlag?"cancelling":"running")
+			:!job.error.empty()?"failed"
+			:job.cancelFlag?"cancelled":"finished";
+	json::Object obj;
+	obj.set("id", job.id);
+	obj.set("type", job.type);
+	obj.set("state", state);
+	obj.set("done", job.done);
+	obj.set("total", job.total);
+	obj.set("started", unixTime(job.started));
+	if (job.done == job.total) obj.set("finished", unixTime(job.finished));
+	if (!job.error.empty()) obj.set("error", job.error);
+	if (withResult) {
+		json::Object res;
+		for (const auto &r: job.results) res.set(r.first, r.second);
+		obj.set("result", json::Value(res));
+	}
+	return json::Value(obj);
+}
+
+json::Value JobManager::status(std::uint64_t id) const {
+	std::lock_guard _(lock);
+	auto iter = jobs.find(id);
+	if (iter == jobs.end()) return json::Value();
+	return jobStatus(*iter->second, true);
+}
+
+json::Value JobManager::list() const {
+	std::lock_guard _(lock);
+	json::Array out;
+	for (const auto &j: jobs) out.push_back(jobStatus(*j.second, false));
+	return json::Value(out);
+}
+
+bool JobManager::cancel(std::uint64_t id) {
+	std::lock_guard _(lock);
+	auto iter = jobs.find(id);
+	if (iter == jobs.end()) return false;
+	iter->second->cancelFlag = true;
+	return true;
+}
+
+void JobManager::cleanup() {
+	std::size_t finished = 0;
+	for (const auto &j: jobs) if (j.second->done == j.second->total) finished++;
+	for (auto iter = jobs.begin(); iter != jobs.end() && finished > keepFinished;) {
+		if (iter->second->done == iter->second->total) {
+			iter = jobs.erase(iter);
+			finished--;
+		} else {
+			++iter;
+		}
+	}
+}
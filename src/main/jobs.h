@@ -0,0 +1,140 @@
+/*
+ * jobs.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_JOBS_H_
+#define SRC_MAIN_JOBS_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <imtjson/value.h>
+
+///Limits rate of I/O operations of background jobs
+class RateLimiter {
+public:
+	///Construct limiter
+	/**
+	 * @param rate operations per second, 0 = unlimited
+	 */
+	RateLimiter(std::size_t rate):rate(rate) {}
+	///Acquires operations, blocks when the rate is exceeded
+	void acquire(std::size_t ops);
+protected:
+	std::mutex lock;
+	std::size_t rate;
+	double tokens = 0;
+	std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+};
+
+class JobManager;
+
+///Context of running job, passed to the work function
+class JobContext {
+public:
+	JobContext(JobManager &owner, const std::atomic<bool> &cancelFlag):owner(owner),cancelFlag(cancelFlag) {}
+	///Returns true, when job has been cancelled, work function should return as soon as possible
+	bool cancelled() const {return cancelFlag;}
+	///Accounts I/O operations, blocks when the rate limit is exceeded
+	void throttle(std::size_t ops);
+protected:
+	JobManager &owner;
+	const std::atomic<bool> &cancelFlag;
+};
+
+///Runs maintenance jobs on own threads
+/**
+ * Job is split into shards (usually one shard per symbol). Shards are processed
+ * in parallel by the worker threads. Result of the job is an object, which
+ * contains result of each shard.
+ */
+class JobManager {
+public:
+
+	///Work function, processes one shard and returns its result
+	using WorkFn = std::function<json::Value(JobContext &ctx, const std::string &shard)>;
+	///Called, when all shards are done (can be empty)
+	using FinishFn = std::function<void()>;
+
+	///Construct manager
+	/**
+	 * @param threads count of worker threads
+	 * @param ioRate I/O operations per second for all jobs, 0 = unlimited
+	 */
+	JobManager(unsigned int threads, std::size_t ioRate);
+	~JobManager();
+
+	///Starts a job
+	/**
+	 * @param type type of the job (informative)
+	 * @param shards list of shards
+	 * @param work work function
+	 * @param finish finish function
+	 * @return id of the job
+	 */
+	std::uint64_t start(std::string type, std::vector<std::string> shards, WorkFn work, FinishFn finish = nullptr);
+	///Returns status of the job
+	/**
+	 * @return status object, or undefined, when job doesn't exist
+	 */
+	json::Value status(std::uint64_t id) const;
+	///Returns status of all jobs (without results)
+	json::Value list() const;
+	///Requests cancellation of the job
+	/**
+	 * @retval true cancellation requested
+	 * @retval false job not found
+	 */
+	bool cancel(std::uint64_t id);
+
+	RateLimiter &getLimiter() {return limiter;}
+
+	///Count of finished jobs kept for status
+	static constexpr std::size_t keepFinished = 100;
+
+protected:
+
+	struct Job {
+		std::uint64_t id;
+		std::string type;
+		WorkFn work;
+		FinishFn finish;
+		std::atomic<bool> cancelFlag = false;
+		std::size_t total = 0;
+		std::size_t done = 0;
+		std::map<std::string, json::Value> results;
+		std::string error;
+		std::chrono::system_clock::time_point started;
+		std::chrono::system_clock::time_point finished;
+	};
+
+	using PJob = std::shared_ptr<Job>;
+
+	mutable std::mutex lock;
+	std::condition_variable cond;
+	std::map<std::uint64_t, PJob> jobs;
+	std::deque<std::pair<PJob, std::string> > queue;
+	std::vector<std::thread> workers;
+	RateLimiter limiter;
+	std::uint64_t nextId = 1;
+	bool stopping = false;
+
+	void worker();
+	json::Value jobStatus(const Job &job, bool withResult) const;
+	void cleanup();
+};
+
+#endif /* SRC_MAIN_JOBS_H_ */
@@ -0,0 +1,215 @@
+/*
+ * json_reader.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_JSON_READER_H_
+#define SRC_MAIN_JSON_READER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///Pull parser of JSON stream
+/**
+ * Reads tokens one by one without building a document, so a large body is processed
+ * in constant memory. Commas and colons are consumed silently, structure is not validated
+ * strictly.
+ *
+ * @tparam Source function, returns next character or -1 at the end of the stream
+ */
+template<typename Source>
+class JsonReader {
+public:
+
+	enum Token {
+		begin_object,
+		end_object,
+		begin_array,
+		end_array,
+		///key of an object, use getText()
+		key,
+		///string, use getText()
+		string,
+		///number, use getNumber(), getUInt() or getText()
+		number,
+		///true or false, use getBool()
+		boolean,
+		null,
+		///end of stream
+		end,
+		///unexpected character
+		error
+	};
+
+	JsonReader(Source &&src):src(std::forward<Source>(src)) {}
+
+	///Reads next token
+	Token next();
+	///Skips rest of the value, when last token was begin_object or begin_array
+	void skip();
+
+	std::string_view getText() const {return buffer;}
+	double getNumber() const {return std::strtod(buffer.c_str(), nullptr);}
+	std::uint64_t getUInt() const {return std::strtoull(buffer.c_str(), nullptr, 10);}
+	bool getBool() const {return boolValue;}
+	///Current nesting level
+	std::size_t depth() const {return ctx.size();}
+
+protected:
+	Source src;
+	std::string buffer;
+	std::vector<char> ctx;
+	bool expectKey = false;
+	bool boolValue = false;
+	int putback = -1;
+
+	int get() {
+		if (putback != -1) {
+			int c = putback;
+			putback = -1;
+			return c;
+		}
+		return src();
+	}
+	bool readString();
+	bool readLiteral(const char *rest);
+	static void appendUtf8(std::string &out, std::uint32_t cp);
+};
+
+template<typename Source>
+inline typename JsonReader<Source>::Token JsonReader<Source>::next() {
+	for(;;) {
+		int c = get();
+		switch (c) {
+		case -1: return end;
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+		case ':': break;
+		case ',': expectKey = !ctx.empty() && ctx.back() == 'o'; break;
+		case '{': ctx.push_back('o'); expectKey = true; return begin_object;
+		case '[': ctx.push_back('a'); expectKey = false; return begin_array;
+		case '}':
+		case ']': if (ctx.empty()) return error;
+				  ctx.pop_back();
+				  expectKey = false;
+				  return c == '}'?end_object:end_array;
+		case '"': {
+				if (!readString()) return error;
+				if (expectKey) {
+					expectKey = false;
+					return key;
+				}
+				return string;
+			}
+		case 't': boolValue = true; return readLiteral("rue")?boolean:error;
+		case 'f': boolValue = false; return readLiteral("alse")?boolean:error;
+		case 'n': return readLiteral("ull")?null:error;
+		default:
+			if ((c >= '0' && c <= '9') || c == '-') {
+				buffer.clear();
+				while ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+					buffer.push_back(static_cast<char>(c));
+					c = get();
+				}
+				putback = c;
+				return number;
+			}
+			return error;
+		}
+	}
+}
+
+template<typename Source>
+inline void JsonReader<Source>::skip() {
+	std::size_t d = ctx.size();
+	if (d == 0) return;
+	while (ctx.size() >= d) {
+		Token t = next();
+		if (t == end || t == error) return;
+	}
+}
+
+template<typename Source>
+inline bool JsonReader<Source>::readLiteral(const char *rest) {
+	while (*rest) {
+		if (get() != *rest) return false;
+		++rest;
+	}
+	return true;
+}
+
+template<typename Source>
+inline void JsonReader<Source>::appendUtf8(std::string &out, std::uint32_t cp) {
+	if (cp < 0x80) {
+		out.push_back(static_cast<char>(cp));
+	} else if (cp < 0x800) {
+		out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	} else if (cp < 0x10000) {
+		out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	} else {
+		out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	}
+}
+
+template<typename Source>
+inline bool JsonReader<Source>::readString() {
+	buffer.clear();
+	auto hex4 = [&]() -> int {
+		int r = 0;
+		for (int i = 0; i < 4; i++) {
+			int c = get();
+			r <<= 4;
+			if (c >= '0' && c <= '9') r |= c - '0';
+			else if (c >= 'a' && c <= 'f') r |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') r |= c - 'A' + 10;
+			else return -1;
+		}
+		return r;
+	};
+	for(;;) {
+		int c = get();
+		if (c == -1) return false;
+		if (c == '"') return true;
+		if (c != '\\') {
+			buffer.push_back(static_cast<char>(c));
+			continue;
+		}
+		c = get();
+		switch (c) {
+		case 'b': buffer.push_back('\b');break;
+		case 'f': buffer.push_back('\f');break;
+		case 'n': buffer.push_back('\n');break;
+		case 'r': buffer.push_back('\r');break;
+		case 't': buffer.push_back('\t');break;
+		case 'u': {
+				int cp = hex4();
+				if (cp < 0) return false;
+				if (cp >= 0xD800 && cp < 0xDC00) {
+					if (get() != '\\' || get() != 'u') return false;
+					int lo = hex4();
+					if (lo < 0xDC00 || lo >= 0xE000) return false;
+					cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+				}
+				appendUtf8(buffer, cp);
+			}
+			break;
+		case -1: return false;
+		default: buffer.push_back(static_cast<char>(c));break;
+		}
+	}
+}
+
+#endif /* SRC_MAIN_JSON_READER_H_ */
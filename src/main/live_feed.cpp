@@ -0,0 +1,170 @@
+/*
+ * live_feed.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "live_feed.h"
+
+#include <algorithm>
+#include <map>
+
+#include <imtjson/object.h>
+#include <imtjson/value.h>
+
+static std::vector<std::string_view> splitList(std::string_view list) {
+	std::vector<std::string_view> out;
+	while (!list.empty()) {
+		auto sep = list.find(',');
+		auto item = list.substr(0, sep);
+		if (!item.empty()) out.push_back(item);
+		if (sep == list.npos) break;
+		list = list.substr(sep+1);
+	}
+	return out;
+}
+
+LiveFeed::Subscription LiveFeed::Subscription::parse(std::string_view symbols, std::string_view pairs) {
+	Subscription sub;
+	for (auto s: splitList(symbols)) sub.symbols.emplace_back(s);
+	for (auto p: splitList(pairs)) {
+		auto sep = p.find('/');
+		if (sep == p.npos) sub.symbols.emplace_back(p);
+		else sub.pairs.emplace_back(std::string(p.substr(0, sep)), std::string(p.substr(sep+1)));
+	}
+	std::sort(sub.symbols.begin(), sub.symbols.end());
+	sub.symbols.erase(std::unique(sub.symbols.begin(), sub.symbols.end()), sub.symbols.end());
+	std::sort(sub.pairs.begin(), sub.pairs.end());
+	sub.pairs.erase(std::unique(sub.pairs.begin(), sub.pairs.end()), sub.pairs.end());
+	return sub;
+}
+
+std::string LiveFeed::Subscription::key() const {
+	std::string k;
+	for (const auto &s: symbols) k.append(s).append(",");
+	k.append("|");
+	for (const auto &p: pairs) k.append(p.first).append("/").append(p.second).append(",");
+	return k;
+}
+
+bool LiveFeed::subscribe(userver::PHttpServerRequest &req, Subscription &&sub) {
+	auto s = std::make_shared<Subscriber>();
+	Frame frame;
+	{
+		std::lock_guard _(lock);
+		if (subs.size() >= maxSubscribers) return false;
+		s->req = std::move(req);
+		s->key = sub.key();
+		s->sub = std::move(sub);
+		s->req->setContentType("text/event-stream");
+		s->req->set("Cache-Control", "no-cache");
+		s->req->set("X-Accel-Buffering", "no");
+		s->stream = s->req->send();
+		if (last) frame = std::make_shared<std::string>(encode(lastTime, *last, s->sub));
+		subs.push_back(s);
+	}
+	//headers are sent with the first write, a comment is sent, when there is no snapshot yet
+	post(s, frame?frame:std::make_shared<std::string>(": subscribed\n\n"));
+	return true;
+}
+
+void LiveFeed::publish(std::uint64_t time, SymbolCatalog::PSnapshot snapshot) {
+	if (!snapshot) return;
+	std::vector<PSubscriber> list;
+	{
+		std::lock_guard _(lock);
+		last = snapshot;
+		lastTime = time;
+		list = subs;
+	}
+	//every distinct subscription is encoded once
+	std::map<std::string_view, Frame> frames;
+	for (const auto &s: list) {
+		Frame &f = frames[s->key];
+		if (!f) f = std::make_shared<std::string>(encode(time, *snapshot, s->sub));
+		post(s, f);
+	}
+}
+
+std::size_t LiveFeed::subscribers() const {
+	std::lock_guard _(lock);
+	return subs.size();
+}
+
+std::string LiveFeed::encode(std::uint64_t time, const SymbolCatalog::Snapshot &snapshot, const Subscription &sub) {
+	auto find = [&](std::string_view symbol, double &price) {
+		if (symbol == "usd") {
+			price = 1.0;
+			return true;
+		}
+		auto iter = std::lower_bound(snapshot.begin(), snapshot.end(), symbol, [](const auto &a, std::string_view b){
+			return a.first < b;
+		});
+		if (iter == snapshot.end() || iter->first != symbol) return false;
+		price = iter->second;
+		return true;
+	};
+	json::Object prices;
+	if (sub.symbols.empty() && sub.pairs.empty()) {
+		for (const auto &p: snapshot) prices.set(p.first, p.second);
+	} else {
+		double a, c;
+		for (const auto &s: sub.symbols) {
+			if (find(s, a)) prices.set(s, a);
+		}
+		for (const auto &p: sub.pairs) {
+			if (find(p.first, a) && find(p.second, c)) prices.set(p.first+"/"+p.second, a/c);
+		}
+	}
+	json::Object data;
+	data.set("time", time);
+	data.set("prices", prices);
+	std::string out("id: ");
+	out.append(std::to_string(time)).append("\nevent: prices\ndata: ");
+	out.append(json::Value(data).stringify().str());
+	out.append("\n\n");
+	return out;
+}
+
+void LiveFeed::post(const PSubscriber &s, const Frame &frame) {
+	{
+		std::lock_guard _(s->lock);
+		if (s->closed) return;
+		if (s->writing) {
+			//slow consumer, only the latest frame is kept
+			if (s->pending) skippedCnt++;
+			s->pending = frame;
+			return;
+		}
+		s->writing = frame;
+	}
+	startWrite(s);
+}
+
+void LiveFeed::startWrite(const PSubscriber &s) {
+	//writing frame is held by the subscriber until the write completes
+	s->stream.writeAsync(*s->writing, [this, s](bool ok) {
+		if (ok) sentCnt++;
+		{
+			std::lock_guard _(s->lock);
+			if (ok) {
+				s->writing = std::move(s->pending);
+				s->pending = nullptr;
+				if (!s->writing) return;
+			} else {
+				s->closed = true;
+				s->writing = nullptr;
+				s->pending = nullptr;
+			}
+		}
+		if (ok) startWrite(s);
+		else remove(s);
+	});
+}
+
+void LiveFeed::remove(const PSubscriber &s) {
+	std::lock_guard _(lock);
+	auto iter = std::find(subs.begin(), subs.end(), s);
+	if (iter != subs.end()) subs.erase(iter);
+}
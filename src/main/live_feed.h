@@ -0,0 +1,110 @@
+/*
+ * live_feed.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_LIVE_FEED_H_
+#define SRC_MAIN_LIVE_FEED_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../userver/http_server.h"
+#include "symbol_catalog.h"
+
+///Broadcasts committed prices to subscribers as Server-Sent Events
+/**
+ * Every commit is encoded once for each distinct subscription (subscribers with the same
+ * symbols share the encoded frame) and written asynchronously, so no thread is blocked
+ * by a subscriber.
+ *
+ * Subscriber has at most one write in progress and one pending frame. When a new frame
+ * arrives while a frame is still pending, the pending frame is replaced, so a slow consumer
+ * receives only the latest prices (skipped frames are counted). Subscriber is removed,
+ * when a write fails (client disconnected).
+ */
+class LiveFeed {
+public:
+
+	///Subscribed symbols, both lists empty - all symbols quoted in usd
+	struct Subscription {
+		///symbols quoted in usd
+		std::vector<std::string> symbols;
+		///pairs asset, currency
+		std::vector<std::pair<std::string, std::string> > pairs;
+
+		///Parses comma separated lists (pairs are asset/currency)
+		static Subscription parse(std::string_view symbols, std::string_view pairs);
+		///Key of the subscription, subscribers with the same key share frames
+		std::string key() const;
+	};
+
+	///Construct the feed
+	/**
+	 * @param maxSubscribers max count of subscribers
+	 */
+	LiveFeed(std::size_t maxSubscribers):maxSubscribers(maxSubscribers) {}
+
+	///Subscribes the request
+	/**
+	 * Starts the event stream and sends the last snapshot. The request is held by the feed
+	 * until the client disconnects.
+	 *
+	 * @param req request, moved to the feed on success
+	 * @param sub subscription
+	 * @retval true subscribed
+	 * @retval false too many subscribers, request is untouched
+	 */
+	bool subscribe(userver::PHttpServerRequest &req, Subscription &&sub);
+
+	///Broadcasts committed prices to all subscribers
+	/**
+	 * @param time time of the commit
+	 * @param snapshot committed prices (ordered by symbol)
+	 */
+	void publish(std::uint64_t time, SymbolCatalog::PSnapshot snapshot);
+
+	std::size_t subscribers() const;
+	///Count of frames skipped due to slow subscribers
+	std::uint64_t skipped() const {return skippedCnt;}
+	///Count of frames sent
+	std::uint64_t sent() const {return sentCnt;}
+
+protected:
+	using Frame = std::shared_ptr<const std::string>;
+
+	struct Subscriber {
+		userver::PHttpServerRequest req;
+		userver::Stream stream;
+		Subscription sub;
+		std::string key;
+		std::mutex lock;
+		Frame writing;
+		Frame pending;
+		bool closed = false;
+	};
+	using PSubscriber = std::shared_ptr<Subscriber>;
+
+	mutable std::mutex lock;
+	std::vector<PSubscriber> subs;
+	std::size_t maxSubscribers;
+	std::uint64_t lastTime = 0;
+	SymbolCatalog::PSnapshot last;
+	std::atomic<std::uint64_t> skippedCnt = 0;
+	std::atomic<std::uint64_t> sentCnt = 0;
+
+	static std::string encode(std::uint64_t time, const SymbolCatalog::Snapshot &snapshot, const Subscription &sub);
+	void post(const PSubscriber &s, const Frame &frame);
+	void startWrite(const PSubscriber &s);
+	void remove(const PSubscriber &s);
+};
+
+#endif /* SRC_MAIN_LIVE_FEED_H_ */
@@ -8,13 +8,17 @@
 #include <chrono>
 #include <cmath>
 #include <csignal>
+#include <filesystem>
 #include <map>
+#include <set>
+#include <thread>
 
 #include <imtjson/value.h>
 #include <imtjson/object.h>
 #include <imtjson/string.h>
 #include <imtjson/serializer.h>
 #include <imtjson/parser.h>
+#include <imtjson/array.h>
 #include "../docdb/src/docdblib/aggregator_view.h"
 #include "../docdb/src/docdblib/db.h"
 #include "../docdb/src/docdblib/inspector.h"
@@ -27,6 +31,29 @@
 #include "../userver/openapi.h"
 #include "../userver/query_parser.h"
 #include "../userver/async_provider.h"
+#include "couch_import.h"
+#include "daily_record.h"
+#include "downsample.h"
+#include "iterate_data.h"
+#include "merge_join.h"
+#include "ohlc.h"
+#include "matrix.h"
+#include "output_format.h"
+#include "price_store.h"
+#include "response_cache.h"
+#include "stats.h"
+#include "stream_pool.h"
+#include "symbol_catalog.h"
+#include "ingest.h"
+#include "normalizer.h"
+#include "jobs.h"
+#include "metrics.h"
+#include "async_log.h"
+#include "live_feed.h"
+#include "export_file.h"
+#include "group_commit.h"
+#include "view_rebuild.h"
+#include "retention.h"
 
 using ondra_shared::logInfo;
 using ondra_shared::logWarning;
@@ -39,69 +66,318 @@ using namespace userver;
 static constexpr std::size_t daysec = 24*60*60;
 
 static AsyncProvider asyncProvider;
+static Metrics metrics;
+///Reads long ranges in parallel, configured at start
+static ParallelScan scanner;
+///Generates large responses outside of the HTTP threads, started with the server
+static StreamPool streams;
+///Helper threads of the parallel scans, the HTTP threads are not used for reading the database
+static StreamPool scans;
 
-template<typename Source, typename Fn>
-static void iterateData(Source &pmap, std::string_view asset, std::string_view currency, std::uint64_t from, std::uint64_t to, std::uint64_t timeMult, Fn &&out) {
-	if (to == 0) --to;
-	if (asset == "usd") {
-		auto iter1 = pmap.range({currency, from},{currency, to});
-		while (iter1.next()) {
-			auto t1 = iter1.key(1).getUInt();
-			double v1 = iter1.value().getNumber();
-			out(t1*timeMult, 1.0/v1);
-		}
-	} else if (currency == "usd") {
-		auto iter1 = pmap.range({asset, from},{asset, to});
-		while (iter1.next()) {
-			auto t1 = iter1.key(1).getUInt();
-			double v1 = iter1.value().getNumber();
-			out(t1*timeMult, v1);
+static std::uint64_t currentTime() {
+	return std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+///Metrics of an endpoint generating data
+struct EndpointMetrics {
+	///time of reading the database (microseconds)
+	Histogram &db;
+	///time of formatting (estimated)
+	Histogram &format;
+	///time of writing to the socket
+	Histogram &write;
+	Counter &points;
+	Counter &bytes;
+	Counter &cached;
+
+	static EndpointMetrics &get(std::string_view endpoint) {
+		static thread_local std::map<std::string, std::unique_ptr<EndpointMetrics>, std::less<> > cache;
+		auto iter = cache.find(endpoint);
+		if (iter == cache.end()) {
+			std::string lb = "endpoint=\""+std::string(endpoint)+"\"";
+			iter = cache.emplace(std::string(endpoint), std::unique_ptr<EndpointMetrics>(new EndpointMetrics{
+				metrics.histogram("response_phase_seconds", lb+",phase=\"db\""),
+				metrics.histogram("response_phase_seconds", lb+",phase=\"format\""),
+				metrics.histogram("response_phase_seconds", lb+",phase=\"write\""),
+				metrics.counter("response_points_total", lb),
+				metrics.counter("response_bytes_total", lb),
+				metrics.counter("response_cached_total", lb)
+			})).first;
+		}
+		return *iter->second;
+	}
+};
+
+///Produces next part of a response
+/**
+ * Producers of streamed responses are called repeatedly on the stream pool. A call should
+ * produce a limited part of the response (a slice of the range), so the producer can be
+ * suspended, when the client is slower than the generator
+ *
+ * @retval true more data follow
+ * @retval false response is complete
+ */
+using Producer = std::function<bool(ResponseCapture &)>;
+
+///Sends complete response, stores it to the cache, when it has been captured
+/**
+ * @param cache response cache, can be nullptr (response is streamed)
+ * @param req request
+ * @param key cache key
+ * @param contentType content type
+ * @param symbols symbols used to generate the response ("*" - all symbols)
+ * @param immutable response covers only closed days
+ * @param cap captured response
+ * @param generation generation of the cache taken before the response has been searched,
+ * the response is not stored when its symbols have been invalidated since
+ */
+static void completeResponse(ResponseCache *cache, PHttpServerRequest &req, const std::string &key,
+		std::string_view contentType, std::vector<std::string> &&symbols, bool immutable,
+		ResponseCapture &cap, std::uint64_t generation) {
+	if (cap.captured()) {
+		if (cache) {
+			auto e = cache->store(key, contentType, std::move(cap.body()), std::move(symbols), immutable, generation);
+			ResponseCache::send(req, *e);
+		} else {
+			req->setContentType(contentType);
+			req->send(cap.body());
 		}
 	} else {
-		auto iter1 = pmap.range({asset, from},{asset, to});
-		auto iter2 = pmap.range({currency, from},{currency, to});
-		bool rep_iter1 = false;
-		bool rep_iter2 = false;
-		while ((rep_iter1 || iter1.next()) && (rep_iter2 || iter2.next())) {
-			rep_iter1 = false;
-			rep_iter2 = false;
-			auto t1 = iter1.key(1).getUInt();
-			auto t2 = iter2.key(1).getUInt();
-			if (t1 < t2) rep_iter2 = true;
-			else if (t1 > t2) rep_iter1 = true;
-			else {
-				double v1 = iter1.value().getNumber();
-				double v2 = iter2.value().getNumber();
-				out(t1*timeMult, v1/v2);
+		cap.finish();
+	}
+}
+
+///Records metrics of the response
+/**
+ * @param key cache key (starts by name of the endpoint)
+ * @param cap captured response
+ * @param busy time spent by generating (without time of suspension)
+ * @param send time spent by sending the complete response
+ */
+static void recordResponse(const std::string &key, const ResponseCapture &cap,
+		std::chrono::steady_clock::duration busy, std::chrono::steady_clock::duration send) {
+	auto &em = EndpointMetrics::get(std::string_view(key).substr(0, key.find('|')));
+	auto us = [](auto dur) {
+		return std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(dur).count());
+	};
+	em.db.record(us(busy - cap.getFormatTime()));
+	em.format.record(us(cap.getFormatTime()));
+	em.write.record(us(cap.getWriteTime() + send));
+	em.points.add(cap.getItems());
+	em.bytes.add(cap.getBytes());
+}
+
+///Generates response through the cache
+/**
+ * Response is generated on the calling thread, use only for small responses
+ *
+ * @param gen function(ResponseCapture &), generates the response
+ *
+ * Other parameters are same as completeResponse()
+ */
+template<typename Fn>
+static void cachedResponse(ResponseCache *cache, PHttpServerRequest &req, const std::string &key,
+		std::string_view contentType, std::vector<std::string> &&symbols, bool immutable, Fn &&gen) {
+	std::uint64_t generation = 0;
+	if (cache) {
+		auto e = cache->find(key);
+		if (e) {
+			EndpointMetrics::get(std::string_view(key).substr(0, key.find('|'))).cached.add();
+			ResponseCache::send(req, *e);
+			return;
+		}
+		generation = cache->generation();
+	}
+	auto start = std::chrono::steady_clock::now();
+	ResponseCapture cap(req, contentType, cache?cache->maxEntrySize():0);
+	gen(cap);
+	auto genEnd = std::chrono::steady_clock::now();
+	completeResponse(cache, req, key, contentType, std::move(symbols), immutable, cap, generation);
+	recordResponse(key, cap, genEnd - start, std::chrono::steady_clock::now() - genEnd);
+}
+
+///Response generated in steps on the stream pool
+struct StreamedResponse {
+	ResponseCache *cache;
+	///owner of the request, kept alive by the capture until all writes finish
+	std::shared_ptr<PHttpServerRequest> req;
+	std::string key;
+	std::string_view contentType;
+	std::vector<std::string> symbols;
+	bool immutable;
+	std::uint64_t generation;
+	///creates the producer at the first step
+	std::function<Producer(ResponseCapture &)> init;
+	Producer producer;
+	std::optional<ResponseCapture> cap;
+	std::chrono::steady_clock::duration busy = {};
+};
+
+///Runs one step of the response on the stream pool
+/**
+ * The producer is called until the response is complete, or until the socket has enough
+ * data waiting. Then the thread is released, the next step is queued when the socket
+ * accepts the data. When the producer fails, the client gets status 500, or an incomplete
+ * response when a part has been already sent.
+ */
+static void stepResponse(const std::shared_ptr<StreamedResponse> &r) {
+	auto start = std::chrono::steady_clock::now();
+	try {
+		if (!r->cap) {
+			r->cap.emplace(*r->req, r->contentType, r->cache?r->cache->maxEntrySize():0, r->req,
+					[](std::chrono::steady_clock::duration delay, std::function<void()> &&fn){
+				streams.runAfter(delay, std::move(fn));
+			});
+			r->producer = r->init(*r->cap);
+			r->init = nullptr;
+		}
+		while (r->producer(*r->cap)) {
+			if (r->cap->full() && r->cap->suspend([r]{streams.resume([r]{stepResponse(r);});})) {
+				r->busy += std::chrono::steady_clock::now() - start;
+				return;
 			}
 		}
+	} catch (const ResponseAborted &) {
+		throw;
+	} catch (...) {
+		//status 500 when nothing has been sent, otherwise the response is cut
+		if (r->cap) r->cap->abort();
+		else (*r->req)->sendErrorPage(500);
+		throw;
 	}
+	ResponseCapture &cap = *r->cap;
+	auto genEnd = std::chrono::steady_clock::now();
+	r->busy += genEnd - start;
+	r->producer = nullptr;
+	completeResponse(r->cache, *r->req, r->key, r->contentType, std::move(r->symbols), r->immutable, cap, r->generation);
+	recordResponse(r->key, cap, r->busy, std::chrono::steady_clock::now() - genEnd);
+}
+
+///Generates response on the stream pool
+/**
+ * Cached response is sent directly. Otherwise the request is moved to the stream pool,
+ * so the HTTP thread is blocked neither by reading the database nor by a slow client.
+ * The response is generated in steps, a slow client doesn't block a thread of the pool
+ * either. The generator runs after the handler returns, so it must not refer to the
+ * handler's locals (parameters must be copied). Responds 503, when the pool is full.
+ *
+ * @param gen function(ResponseCapture &) -> Producer, called on the pool at the first step,
+ * creates the producer of the response
+ *
+ * Other parameters are same as completeResponse()
+ */
+template<typename Fn>
+static void cachedResponseAsync(ResponseCache *cache, PHttpServerRequest &req, std::string &&key,
+		std::string_view contentType, std::vector<std::string> &&symbols, bool immutable, Fn &&gen) {
+	std::uint64_t generation = 0;
+	if (cache) {
+		auto e = cache->find(key);
+		if (e) {
+			EndpointMetrics::get(std::string_view(key).substr(0, key.find('|'))).cached.add();
+			ResponseCache::send(req, *e);
+			return;
+		}
+		generation = cache->generation();
+	}
+	auto r = std::make_shared<StreamedResponse>(StreamedResponse{
+		cache, std::make_shared<PHttpServerRequest>(std::move(req)), std::move(key), contentType,
+		std::move(symbols), immutable, generation, std::forward<Fn>(gen), nullptr, std::nullopt
+	});
+	if (!streams.run([r]{stepResponse(r);})) (*r->req)->sendErrorPage(503);
 }
 
-template<typename Source>
-static bool generateData(Source &pmap, PHttpServerRequest &req, const RequestParams &qp, unsigned int timeMult) {
+///Generates series of prices
+/**
+ * @param pmap source of prices
+ * @param req request
+ * @param qp query parameters
+ * @param timeMult multiplier of time of the source to get seconds
+ * @param cache response cache, can be nullptr
+ * @param endpoint name of the endpoint (cache key)
+ * @param catalog catalog of symbols, buckets of downsampling start at the first day of the pair
+ * @param daily daily prices, used by downsampling, when the bucket is at least one day (optional)
+ */
+template<typename Source, typename Daily = Source>
+static bool generateData(Source &pmap, PHttpServerRequest &req, const RequestParams &qp, unsigned int timeMult, ResponseCache *cache, std::string_view endpoint,
+		const SymbolCatalog &catalog, Daily *daily = nullptr) {
 	if (req->getMethod() == "GET") {
 		auto asset=qp["asset"];
 		auto currency=qp["currency"];
 		auto from=qp["from"].getUInt();
 		auto to=qp["to"].getUInt();
+		bool fill=qp["fill"] == "true";
+		auto points=qp["points"].getUInt();
+		bool minmax=qp["sampling"] == "minmax";
+		//buckets start at the first data, not at 1970
+		std::uint64_t firstTime = points?catalog.firstTime(asset, currency):0;
 
-		req->setContentType("application/json");
-		auto s = req->send();
-		s.putChar('[');
-		bool comma = false;
-		char buffer[200];
-		iterateData(pmap, asset, currency, from, to, timeMult, [&](std::uintptr_t t1, double v1){
-			if (comma) {
-				s.write(",\r\n");
+		auto selFmt = selectOutputFormat(qp["format"], req->get("Accept"));
+		if (!selFmt) {
+			req->sendErrorPage(400);
+			return true;
+		}
+		OutputFormat fmt = *selFmt;
+
+		std::string key(endpoint);
+		key.append("|").append(asset).append("|").append(currency)
+		   .append("|").append(std::to_string(from)).append("|").append(std::to_string(to))
+		   .append("|").append(std::to_string(fill)).append("|").append(std::to_string(static_cast<int>(fmt)));
+		if (points) key.append("|").append(std::to_string(points)).append(minmax?"|m":"|l");
+		if (qp["field"].defined) key.append("|").append(qp["field"]);
+		bool immutable = to && to*timeMult <= currentTime()/daysec*daysec;
+
+		cachedResponseAsync(cache, req, std::move(key), outputContentType(fmt), {std::string(asset), std::string(currency)}, immutable,
+				[=, &pmap, asset = std::string(asset), currency = std::string(currency)](ResponseCapture &s) -> Producer {
+			using Write = std::function<void(std::uint64_t, double)>;
+			//state of the response kept between steps
+			struct State {
+				State(ResponseCapture &s, OutputFormat fmt):wr(s, fmt, 1, ",\r\n") {}
+				SeriesWriter<ResponseCapture> wr;
+				Write write;
+				std::optional<LTTBDownsampler<Write> > lttb;
+				std::optional<MinMaxDownsampler<Write> > mm;
+				std::optional<PairReader<Source> > reader;
+				std::optional<PairReader<Daily> > dailyReader;
+			};
+			auto st = std::make_shared<State>(s, fmt);
+			st->write = [&s, &wr = st->wr](std::uint64_t t1, double v1){
+				s.format([&]{wr.push(t1, &v1);});
+			};
+			st->wr.begin();
+			if (points) {
+				//buckets are in seconds
+				std::uint64_t sfrom = std::max<std::uint64_t>(from*timeMult, firstTime);
+				std::uint64_t sto = to?to*timeMult:currentTime();
+				std::uint64_t w;
+				if (minmax) {
+					w = bucketWidth(sfrom, sto, std::max<std::uint64_t>(points/2, 1), timeMult);
+					st->mm.emplace(sfrom, w, st->write);
+				} else {
+					w = bucketWidth(sfrom, sto, std::max<std::uint64_t>(points, 3) - 2, timeMult);
+					st->lttb.emplace(sfrom, w, st->write);
+				}
+				if (daily && timeMult == 1 && w >= daysec) {
+					st->dailyReader.emplace(scanner, *daily, asset, currency, from/daysec, sto/daysec+1, daysec, fill);
+				} else {
+					st->reader.emplace(scanner, pmap, asset, currency, from, to, timeMult, fill);
+				}
 			} else {
-				comma = true;
+				st->reader.emplace(scanner, pmap, asset, currency, from, to, timeMult, fill);
 			}
-			snprintf(buffer,200,"[%lu, %g]", t1, v1);
-			s.write(buffer);
+			return [st](ResponseCapture &) {
+				auto push = [&](std::uint64_t t, double v) {
+					if (st->lttb) st->lttb->push(t, v);
+					else if (st->mm) st->mm->push(t, v);
+					else st->write(t, v);
+				};
+				if (st->reader?st->reader->read(push):st->dailyReader->read(push)) return true;
+				if (st->lttb) st->lttb->finish();
+				if (st->mm) st->mm->finish();
+				st->wr.end();
+				return false;
+			};
 		});
-		s.putChar(']');
-		s.flush();
 		return true;
 	} else {
 		return false;
@@ -110,16 +386,30 @@ static bool generateData(Source &pmap, PHttpServerRequest &req, const RequestPar
 
 class MyHttpServer: public OpenAPIServer {
 public:
-	MyHttpServer():lo("http") {}
+	MyHttpServer(std::size_t cacheSize)
+		:cache(cacheSize),lo("http"),alog(8192, [this](const std::string &line){
+			std::lock_guard _(mx);
+			lo.progress("$1", line);
+		}) {
+		metrics.gauge("log_dropped_lines","",[this]{return static_cast<double>(alog.dropped());});
+	}
+
+	ResponseCache cache;
 
 	virtual void log(ReqEvent event, const HttpServerRequest &req) noexcept override {
 		if (event == ReqEvent::done) {
-			std::lock_guard _(mx);
 			auto now = std::chrono::system_clock::now();
 			auto dur = std::chrono::duration_cast<std::chrono::microseconds>(now-req.getRecvTime());
+			int status = req.getStatus();
+			std::string_view path = req.getPath();
+			routeMetrics(path, status).record(dur.count());
 			char buff[100];
 			snprintf(buff,100,"%1.3f ms", dur.count()*0.001);
-			lo.progress("#$1 $2 $3 $4 $5 $6", req.getIdent(), req.getStatus(), req.getMethod(), req.getHost(), req.getPath(), buff);
+			std::string line("#");
+			line.append(req.getIdent()).append(" ").append(std::to_string(status))
+				.append(" ").append(req.getMethod()).append(" ").append(req.getHost())
+				.append(" ").append(path).append(" ").append(buff);
+			alog.push(std::move(line));
 		}
 	}
 	virtual void log(const HttpServerRequest &req, const std::string_view &msg) noexcept override {
@@ -139,19 +429,25 @@ public:
 protected:
 	std::mutex mx;
 	ondra_shared::LogObject lo;
+	AsyncLog alog;
 
-};
-
-template<typename T>
-void updatePrice(T &iter, double price) {
-	if (iter.second == 0) {
-		iter.first = price;
-		iter.second = 1;
-	} else {
-		iter.first += price;
-		iter.second ++;
+	///Returns latency histogram of the route (first segment of the path)
+	static Histogram &routeMetrics(std::string_view path, int status) {
+		auto pos = path.find_first_of("?/", 1);
+		std::string_view route = path.substr(0, pos);
+		//static files and unknown paths are not reported separately
+		if (status == 404) route = "unknown";
+		else if (route.size() < 2 || route.find('.') != route.npos) route = "static";
+		static thread_local std::map<std::string, Histogram *, std::less<> > cache;
+		auto iter = cache.find(route);
+		if (iter == cache.end()) {
+			Histogram &h = metrics.histogram("http_request_duration_seconds", "route=\""+std::string(route)+"\"");
+			iter = cache.emplace(std::string(route), &h).first;
+		}
+		return *iter->second;
 	}
-}
+
+};
 
 int main(int argc, char **argv) {
 
@@ -171,6 +467,7 @@ int main(int argc, char **argv) {
 	auto server_section = app.config["server"];
 	auto db_section = app.config["db"];
 	auto www_section = app.config["www"];
+	auto jobs_section = app.config["jobs"];
 
 
 
@@ -188,26 +485,45 @@ int main(int argc, char **argv) {
 	};
 
 	DB db(db_section.mandatory["path"].getPath(), cfg);
-	MyHttpServer server;
+	auto groupLatency = db_section["group_commit_latency_us"];
+	auto groupMaxMB = db_section["group_commit_max_mb"];
+	GroupCommit writer(db, std::chrono::microseconds(groupLatency.defined()?groupLatency.getUInt():2000),
+			(groupMaxMB.defined()?groupMaxMB.getUInt():8) * 1024 * 1024, metrics);
+	metrics.gauge("commit_writes", "", [&]{return static_cast<double>(writer.writes());});
+	metrics.gauge("commit_batches", "", [&]{return static_cast<double>(writer.batches());});
+	MyHttpServer server(server_section["cache_size_mb"].getUInt() * 1024 * 1024);
 
 	JsonMap pmap(db,"pmap");
+	JsonMap meta(db,"meta");
+	std::size_t importBatchSize = std::max<std::size_t>(1, db_section["import_batch_mb"].getUInt()) * 1024 * 1024;
+	std::string storage = db_section["storage"].getString();
+	PriceStore priceStore(db, pmap, storage == "columnar"?PriceStore::Mode::columnar:PriceStore::Mode::json);
+	Retention retention(priceStore, writer);
+	{
+		auto retention_section = app.config["retention"];
+		retention.configure(retention_section["minute_days"].getUInt(), Retention::parseTiers(retention_section["tiers"].getString()));
+	}
 	AggregatorView<JsonMap::AggregatorAdapter> dailyPrice(pmap, "daily", [](json::Value key, IMapKey &mp){
 		json::Value symb = key[0];
 		std::size_t sec = key[1].getUInt();
 		std::size_t day = sec/(daysec);
 		std::size_t from = day*(daysec);
 		std::size_t to = (day+1)*(daysec);
-		mp.range({symb,day}, {symb, from}, {symb, to}, false, json::Value());
-	}, [](JsonMap::Iterator &iter, const json::Value &) -> json::Value {
-		if (!iter.next()) return json::Value();
-		double z= iter.value().getNumber();
-		unsigned int count = 1;
-		while (iter.next()) {
-			z+= iter.value().getNumber();
-			count ++;
+		mp.range({symb,day}, {symb, from}, {symb, to}, false, {symb, from, to});
+	}, [&](JsonMap::Iterator &iter, const json::Value &range) -> json::Value {
+		//sealed and rolled up days are no longer in the minute map
+		if (priceStore.indirect()) {
+			auto siter = priceStore.range({range[0], range[1]},{range[0], range[2]});
+			return DailyRecord::aggregate(siter);
 		}
-		return z/count;
+		return DailyRecord::aggregate(iter);
 	});
+	DailyFieldView dailyMean(dailyPrice, DailyRecord::Field::mean);
+	//one view per field, responses are generated after the handler returns
+	std::vector<DailyFieldView<decltype(dailyPrice)> > dailyFields;
+	for (int f = 0; f <= static_cast<int>(DailyRecord::Field::last); f++) {
+		dailyFields.emplace_back(dailyPrice, static_cast<DailyRecord::Field>(f));
+	}
 
 	AggregatorView<decltype(dailyPrice)::AggregatorAdapter> totalRange(dailyPrice, "total", [](json::Value key, IMapKey &mp){
 		json::Value symb = key[0];
@@ -224,6 +540,86 @@ int main(int argc, char **argv) {
 		return {beg, end, cnt};
 	});
 
+	SymbolCatalog catalog(std::max<std::size_t>(1, server_section["snapshot_minutes"].getUInt()));
+	for (auto iter = totalRange.scan(); iter.next();) {
+		json::Value v = iter.value();
+		catalog.set(iter.key().getString(), {v[0].getUInt(), v[1].getUInt(), v[2].getUInt()});
+	}
+
+	std::string exportPath = db_section["export_path"].defined()?db_section["export_path"].getPath():std::string();
+	std::atomic<std::uint64_t> exportGeneration = 0;
+	//exports of finished days are reused, so they are dropped when historical data of their symbols change
+	auto dropExports = [&](const std::set<std::string, std::less<> > &symbols) {
+		if (exportPath.empty()) return;
+		exportGeneration++;
+		std::error_code ec;
+		std::vector<std::filesystem::path> drop;
+		for (const auto &e: std::filesystem::directory_iterator(exportPath, ec)) {
+			if (e.path().extension() != ".mmpx") continue;
+			std::string stem = e.path().stem().string();
+			bool hit = false;
+			if (stem.compare(0, 4, "day-") == 0 && stem.find_first_not_of("0123456789", 4) == stem.npos) {
+				//day-<day>.mmpx, all symbols of the day
+				auto contained = readExportSymbols(e.path().string());
+				hit = contained.empty() || std::any_of(contained.begin(), contained.end(), [&](const std::string &x){
+					return symbols.find(x) != symbols.end();
+				});
+			} else {
+				//<symbol>-<from>-<to>.mmpx
+				auto p = stem.rfind('-');
+				if (p != stem.npos && p > 0) p = stem.rfind('-', p-1);
+				hit = p != stem.npos && symbols.find(std::string_view(stem).substr(0, p)) != symbols.end();
+			}
+			if (hit) drop.push_back(e.path());
+		}
+		for (const auto &f: drop) std::filesystem::remove(f, ec);
+	};
+	//historical data has been changed (import, clean, purge, retention)
+	auto historyChanged = [&](const std::set<std::string, std::less<> > &symbols) {
+		server.cache.invalidate(symbols, true);
+		dropExports(symbols);
+	};
+
+	//writing any minute of the day marks the day dirty, so touch first minute of every day
+	ViewRebuild dailyRebuild(db, meta, "daily", DailyRecord::version, [&](const std::string &symbol, JobContext *ctx) {
+		Batch batch;
+		std::uint64_t days = 0;
+		auto diter = dailyPrice.range({symbol, 0},{symbol, std::numeric_limits<std::uint64_t>::max()});
+		while (diter.next()) {
+			if (ctx) {
+				if (ctx->cancelled()) return false;
+				ctx->throttle(1440);
+			}
+			std::uint64_t day = diter.key(1).getUInt();
+			auto miter = priceStore.minuteRange({symbol, day*daysec},{symbol, (day+1)*daysec});
+			if (miter.next()) {
+				pmap.set(batch, {symbol, miter.time()}, miter.price());
+			} else {
+				//rolled up day has no minutes, erasing a missing key marks the day dirty as well
+				pmap.erase(batch, {symbol, day*daysec});
+			}
+			if (++days % 100 == 0) {
+				writer.commit(batch);
+				batch.Clear();
+			}
+		}
+		writer.commit(batch);
+		server.cache.invalidate({symbol}, true);
+		return true;
+	});
+	{
+		std::vector<std::string> symbols;
+		catalog.forEach([&](const std::string &symbol, const SymbolCatalog::Info &) {
+			symbols.push_back(symbol);
+		});
+		//startup - rebuild everything before the server starts, lazy - serve immediately
+		if (dailyRebuild.init(symbols) && db_section["view_rebuild"].getString() == "startup") {
+			for (const auto &symbol: dailyRebuild.pending()) dailyRebuild.rebuild(symbol, nullptr);
+		}
+	}
+
+	OHLCViews ohlcViews(priceStore);
+	if (ohlcViews.empty()) ohlcViews.populate(db, pmap);
 
 	server.setInfo({
 		"Crypto Prices API","1.0","Crypto Prices API","","Ondrej Novak","","nov.ondrej@gmail.com"
@@ -243,28 +639,30 @@ int main(int argc, char **argv) {
 										}}
 								}}
 						}}
-		},{{202,"Accepted",{}}})
+		},{{202,"Accepted",{}},{400,"Malformed or truncated dump",{}}})
 		.handler([&](PHttpServerRequest &req, const RequestParams &) mutable {
 
 			if (!checkHost(req->getHost())) {
 				req->sendErrorPage(403);return true;
 			}
 			Stream b = req->getBody();
-			json::Value v = json::Value::parse([&]()->int {
+			CouchImporter importer(writer, pmap, importBatchSize);
+			auto stats = importer.run([&]()->int {
 				return b.getChar();
 			});
-			json::Value rows = v["rows"];
-			for (json::Value rw: rows) {
-				json::Value doc = rw["doc"];
-				std::uint64_t time = rw["id"].getUInt()*10;
-				json::Value prices = doc["prices"];
-				docdb::Batch b;
-				for (json::Value c: prices) {
-					pmap.set(b, {c.getKey(), time}, c.getNumber());
-				}
-				db.commitBatch(b);
-			};
-			req->sendErrorPage(202);
+			const auto &symbols = importer.getSymbols();
+			logNote("Import: rows=$1, prices=$2, batches=$3, $4 rows/s, $5 MB/s$6", stats.rows, stats.prices, stats.batches,
+					stats.rows/std::max(stats.seconds,1e-6), stats.bytes/std::max(stats.seconds,1e-6)/(1024.0*1024.0),
+					stats.complete?"":" (incomplete)");
+			historyChanged(symbols);
+			for (const auto &symbol: symbols) {
+				json::Value v = totalRange.lookup(symbol);
+				if (v.defined()) catalog.set(symbol, {v[0].getUInt(), v[1].getUInt(), v[2].getUInt()});
+			}
+			catalog.clearSnapshots();
+			req->setStatus(stats.complete?202:400);
+			req->setContentType("application/json");
+			req->send(stats.toJson().stringify().str());
 			return true;
 	});
 
@@ -275,27 +673,27 @@ int main(int argc, char **argv) {
 		}}}}})
 	.handler([&](PHttpServerRequest &req, const RequestParams &params)mutable{
 		if (req->getMethod() == "GET") {
-			req->setContentType("application/json");;
-			Stream s = req->send();
-			s.putCharNB('{');
-			bool comma = false;
-			for (auto iter = totalRange.scan(); iter.next();) {
-				if (comma) {
-					s.write(",\r\n");
-				} else {
-					comma = true;
-				}
-				auto k = iter.key();
-				auto v = iter.value();
-				if (k.getString() == "usd") {
-					v = {0,999999,999999};
-				}
-				k.serialize([&](char c){s.putCharNB(c);});
-				s.putChar(':');
-				v.serialize([&](char c){s.putCharNB(c);});
-			}
-			s.putCharNB('}');
-			s.flush();
+			//keyed by the version of the catalog, so commits of prices don't invalidate it
+			cachedResponse(&server.cache, req, "symbols|"+std::to_string(catalog.version()), "application/json", {}, false, [&](ResponseCapture &s){
+				s.putCharNB('{');
+				bool comma = false;
+				catalog.forEach([&](const std::string &symbol, const SymbolCatalog::Info &nfo) {
+					if (comma) {
+						s.write(",\r\n");
+					} else {
+						comma = true;
+					}
+					json::Value k = symbol;
+					json::Value v = {nfo.firstDay, nfo.lastDay, nfo.days};
+					if (symbol == "usd") {
+						v = {0,999999,999999};
+					}
+					k.serialize([&](char c){s.putCharNB(c);});
+					s.putChar(':');
+					v.serialize([&](char c){s.putCharNB(c);});
+				});
+				s.putCharNB('}');
+			});
 			return true;
 		} else {
 			return false;
@@ -307,7 +705,11 @@ int main(int argc, char **argv) {
 				{"asset","query","string","Selected asset"},
 				{"currency","query","string","Selected currency"},
 				{"from","query","int64","From timestamp",{}},
-				{"to","query","int64","To timestamp",{},false}
+				{"to","query","int64","To timestamp",{},false},
+				{"fill","query","boolean","Cross pairs: fill missing minutes with last known price",{},false},
+				{"format","query","string","Output format: json, csv, bin, bin-delta (default: according to Accept)",{},false},
+				{"points","query","integer","Return at most given count of points (downsampled)",{},false},
+				{"sampling","query","string","Downsampling method: lttb (default), minmax",{},false}
 		},{
 				{200,"OK",{{"application/json","graph","array","Graph of prices",{
 						{"pair","anyOf","",{
@@ -317,24 +719,43 @@ int main(int argc, char **argv) {
 				}}}}
 		})
 	.handler([&](PHttpServerRequest &req, const RequestParams &params){
-		return generateData(pmap, req, params,1);
+		//downsampled responses are small enough to be cached
+		if (params["points"].getUInt()) {
+			dailyRebuild.ensure(params["asset"]);
+			dailyRebuild.ensure(params["currency"]);
+		}
+		return generateData(priceStore, req, params,1, params["points"].getUInt()?&server.cache:nullptr, "minute", catalog, &dailyMean);
 	});
 	server.addPath("/daily")
 		.GET("Public","Download daily public data","",{
 				{"asset","query","string","Selected asset"},
 				{"currency","query","string","Selected currency"},
 				{"from","query","int64","From timestamp",{},false},
-				{"to","query","int64","To timestamp",{},false}
+				{"to","query","int64","To timestamp",{},false},
+				{"fill","query","boolean","Cross pairs: fill missing days with last known price",{},false},
+				{"format","query","string","Output format: json, csv, bin, bin-delta (default: according to Accept)",{},false},
+				{"points","query","integer","Return at most given count of points (downsampled)",{},false},
+				{"sampling","query","string","Downsampling method: lttb (default), minmax",{},false},
+				{"field","query","string","Field of the day: mean (default), open, high, low, close, count, first, last (count, first and last only for currency usd)",{},false}
 		},{
 				{200,"OK",{{"application/json","daily","array","Daily prices",{
 						{"pair","oneOf","",{
 								{"time","int64","Time in seconds"},
 								{"price","number","Price"}
 						}}
-				}}}}
+				}}}},
+				{400,"Invalid field",{}}
 		})
 	.handler([&](PHttpServerRequest &req, const RequestParams &params){
-		return generateData(dailyPrice, req, params,daysec);
+		auto field = DailyRecord::parseField(std::string_view(params["field"]));
+		//count and times can't be inverted or divided
+		if (!field || (!DailyRecord::isPrice(*field) && (params["asset"] == "usd" || params["currency"] != "usd"))) {
+			req->sendErrorPage(400);
+			return true;
+		}
+		dailyRebuild.ensure(params["asset"]);
+		dailyRebuild.ensure(params["currency"]);
+		return generateData(dailyFields[static_cast<int>(*field)], req, params,daysec, &server.cache, "daily", catalog);
 	});
 	server.addPath("/ohlc")
 			.GET("Public","Download OHLC public data","",{
@@ -342,7 +763,10 @@ int main(int argc, char **argv) {
 					{"currency","query","string","Selected currency"},
 					{"from","query","int64","From timestamp",{},false},
 					{"to","query","int64","To timestamp",{},false},
-					{"tfrm","query","integer","Timeframe"}
+					{"tfrm","query","integer","Timeframe"},
+					{"fill","query","boolean","Cross pairs: fill missing minutes with last known price",{},false},
+					{"format","query","string","Output format: json, csv, bin, bin-delta (default: according to Accept)",{},false},
+					{"points","query","integer","Return at most given count of candles (timeframe is enlarged)",{},false}
 			},{
 					{200,"OK",{{"application/json","ohlc","array","List of [time,o,h,l,c]",{
 							{"pair","oneOf","",{
@@ -361,49 +785,585 @@ int main(int argc, char **argv) {
 			auto from=params["from"].getUInt();
 			auto to=params["to"].getUInt();
 			auto tfrm = std::max<std::size_t>(1,params["timeframe"].getUInt())*60;
+			bool fill=params["fill"] == "true";
+			auto points=params["points"].getUInt();
+			if (points) {
+				//one more frame can be produced due to alignment
+				//buckets start at the first data, not at 1970
+				std::uint64_t sfrom = std::max<std::uint64_t>(from, catalog.firstTime(asset, currency));
+				tfrm = std::max<std::uint64_t>(tfrm, bucketWidth(sfrom, to?to:currentTime(), std::max<std::uint64_t>(points,2)-1, 60));
+			}
 
-			char buff[500];
-
-			req->setContentType("application/json");;
-			Stream s = req->send();
-			s.putCharNB('[');
-			bool comma = false;
+			auto selFmt = selectOutputFormat(params["format"], req->get("Accept"));
+			if (!selFmt) {
+				req->sendErrorPage(400);
+				return true;
+			}
+			OutputFormat fmt = *selFmt;
 
-			std::size_t lastFrame = 0;
-			double o,c,h,l;
+			std::string key("ohlc|");
+			key.append(asset).append("|").append(currency)
+			   .append("|").append(std::to_string(from)).append("|").append(std::to_string(to))
+			   .append("|").append(std::to_string(tfrm)).append("|").append(std::to_string(fill))
+			   .append("|").append(std::to_string(static_cast<int>(fmt)));
+			bool immutable = to && to <= currentTime()/daysec*daysec;
 
-			auto flushData = [&]{
-				if (lastFrame) {
-					if (comma) s.write(",\n"); else comma = true;
-					snprintf(buff,sizeof(buff),"[%lu, %g, %g, %g, %g]", lastFrame*tfrm, o,h,l,c);
-					s.write(buff);
+			cachedResponseAsync(&server.cache, req, std::move(key), outputContentType(fmt), {std::string(asset), std::string(currency)}, immutable,
+					[=, &priceStore, &ohlcViews, asset = std::string(asset), currency = std::string(currency)](ResponseCapture &s) -> Producer {
+				//state of the response kept between steps
+				using Open = SeriesOpen<PriceStore>;
+				struct State {
+					State(ResponseCapture &s, OutputFormat fmt, const ParallelScan &scan, std::string asset, std::string currency, std::uint64_t from, std::uint64_t to)
+						:wr(s, fmt, 4, ",\n"),slices(scan, from, to, 1),asset(std::move(asset)),currency(std::move(currency)) {}
+					SeriesWriter<ResponseCapture> wr;
+					RangeSlices slices;
+					std::string asset;
+					std::string currency;
+					//cross pairs with fill forward are read by a resumable join (of candles, rolled up data keep high and low)
+					std::optional<MergeJoin<Open, Open, Candle> > joined;
+					std::size_t lastFrame = 0;
+					double o = 0, c = 0, h = 0, l = 0;
+				};
+				auto st = std::make_shared<State>(s, fmt, scanner, asset, currency, from, to);
+				bool cross = asset != "usd" && currency != "usd";
+				if (cross && fill) {
+					std::uint64_t end = to?to:std::numeric_limits<std::uint64_t>::max();
+					st->joined.emplace(from, Open{&priceStore, st->asset, end}, Open{&priceStore, st->currency, end}, true);
 				}
-			};
+				st->wr.begin();
 
-			iterateData(pmap, asset, currency, from, to, 1, [&](std::uint64_t t, double v) {
-				std::size_t f = t/tfrm;
-				if (f != lastFrame) {
-					flushData();
-					o=c=h=l=v;
-					lastFrame = f;
-				} else {
-					c=v;
-					h=std::max(h,v);
-					l=std::min(l,v);
-				}
+				return [=, &s, &priceStore, &ohlcViews](ResponseCapture &) {
+					State &x = *st;
+					auto flushData = [&]{
+						if (x.lastFrame) {
+							double vals[4] = {x.o,x.h,x.l,x.c};
+							s.format([&]{x.wr.push(x.lastFrame*tfrm, vals);});
+						}
+					};
+					auto finish = [&]{
+						flushData();
+						x.wr.end();
+						return false;
+					};
+
+					auto addCandle = [&](std::uint64_t t, double co, double ch, double cl, double cc) {
+						std::size_t f = t/tfrm;
+						if (f != x.lastFrame) {
+							flushData();
+							x.o = co; x.h = ch; x.l = cl; x.c = cc;
+							x.lastFrame = f;
+						} else {
+							x.c = cc;
+							x.h = std::max(x.h,ch);
+							x.l = std::min(x.l,cl);
+						}
+					};
+					if (x.joined) {
+						if (x.joined->read(PairReader<PriceStore>::joinItems, [&](std::uint64_t t, const Candle &a, const Candle &b){
+							Candle cd = crossCandle(t, a, b);
+							addCandle(t, cd.o, cd.h, cd.l, cd.c);
+						})) return true;
+						return finish();
+					}
+					auto addMinutes = [&](std::uint64_t from, std::uint64_t to) {
+						//long ranges are folded in parallel shards, candles split by a shard boundary are merged by addCandle
+						if (iterateShards<Candle>(scanner, priceStore, asset, currency, from, to,
+								[&](std::uint64_t f, std::uint64_t t, std::vector<Candle> &candles) {
+							iterateCandles(priceStore, asset, currency, f, t, tfrm, false, [&](const Candle &cd) {
+								if (candles.empty() || candles.back().t != cd.t) {
+									candles.push_back(cd);
+								} else {
+									Candle &last = candles.back();
+									last.h = std::max(last.h, cd.h);
+									last.l = std::min(last.l, cd.l);
+									last.c = cd.c;
+								}
+							});
+						}, [&](std::vector<Candle> &candles) {
+							for (const Candle &cd: candles) addCandle(cd.t, cd.o, cd.h, cd.l, cd.c);
+						})) return;
+						iterateCandles(priceStore, asset, currency, from, to, tfrm, false, [&](const Candle &cd) {
+							addCandle(cd.t, cd.o, cd.h, cd.l, cd.c);
+						});
+					};
+
+					//one slice of the range per step, candles split by slices are merged by addCandle
+					std::uint64_t from, to;
+					if (!x.slices.next(priceStore, asset, currency, from, to)) return finish();
+					//candles of single symbol quoted in usd can be folded from precomputed candles
+					std::uint64_t tf = OHLCViews::bestTimeframe(tfrm);
+					bool inverted = asset == "usd";
+					std::uint64_t ffrom = (from+tf-1)/std::max<std::uint64_t>(tf,1);
+					std::uint64_t fto = (to?to:std::numeric_limits<std::uint64_t>::max())/std::max<std::uint64_t>(tf,1);
+					if (tf && (inverted || currency == "usd") && ffrom < fto) {
+						//unaligned head and tail are read from minute data
+						if (from < ffrom*tf) addMinutes(from, ffrom*tf);
+						ohlcViews.range(tf, inverted?currency:asset, ffrom, fto, [&](std::uint64_t t, double co, double ch, double cl, double cc){
+							if (inverted) addCandle(t, 1.0/co, 1.0/cl, 1.0/ch, 1.0/cc);
+							else addCandle(t, co, ch, cl, cc);
+						});
+						addMinutes(fto*tf, to);
+					} else {
+						addMinutes(from, to);
+					}
+					if (!x.slices.last()) return true;
+					return finish();
+				};
 			});
-			flushData();
-			s.putCharNB(']');
-			s.flush();
 			return true;
 		} else {
 			return false;
 		}
 	});
+	server.addPath("/matrix")
+		.GET("Public","Download minute data of several assets in one currency","",{
+				{"assets","query","string","Comma separated list of assets (max 255)"},
+				{"currency","query","string","Selected currency"},
+				{"from","query","int64","From timestamp",{}},
+				{"to","query","int64","To timestamp",{},false},
+				{"timeframe","query","integer","Timeframe in minutes, row contains last price of each asset in the frame",{},false},
+				{"fill","query","boolean","Fill missing prices with last known price",{},false},
+				{"layout","query","string","rows - shared time axis (default), series - object of series grouped by asset (always json)",{},false},
+				{"format","query","string","Output format: json, csv, bin, bin-delta (default: according to Accept)",{},false}
+		},{
+				{200,"OK",{{"application/json","matrix","array","Rows [time, price1, price2,...] in order of the assets, null - no price",{
+						{"row","anyOf","",{
+								{"time","int64","Time in seconds"},
+								{"price","number","Price"}
+						}}
+				}}}},
+				{400,"Invalid list of assets",{}}
+		})
+	.handler([&](PHttpServerRequest &req, const RequestParams &params){
+		if (req->getMethod() == "GET") {
+			std::vector<std::string> assets;
+			std::string list(params["assets"]);
+			for (std::size_t pos = 0; pos <= list.size();) {
+				auto sep = std::min(list.find(',', pos), list.size());
+				if (sep > pos) assets.push_back(list.substr(pos, sep - pos));
+				pos = sep + 1;
+			}
+			//binary format stores count of columns in one byte
+			if (assets.empty() || assets.size() > 255) {
+				req->sendErrorPage(400);
+				return true;
+			}
+			auto currency=params["currency"];
+			auto from=params["from"].getUInt();
+			auto to=params["to"].getUInt();
+			auto tfrm=params["timeframe"].getUInt()*60;
+			bool fill=params["fill"] == "true";
+			bool series=params["layout"] == "series";
+			auto selFmt = selectOutputFormat(params["format"], req->get("Accept"));
+			if (!selFmt) {
+				req->sendErrorPage(400);
+				return true;
+			}
+			OutputFormat fmt = series?OutputFormat::json:*selFmt;
+			std::size_t n = assets.size();
+
+			std::string key("matrix|");
+			key.append(list).append("|").append(currency)
+			   .append("|").append(std::to_string(from)).append("|").append(std::to_string(to))
+			   .append("|").append(std::to_string(tfrm)).append("|").append(std::to_string(fill))
+			   .append("|").append(std::to_string(series)).append("|").append(std::to_string(static_cast<int>(fmt)));
+
+			std::vector<std::string> symbols(assets);
+			symbols.push_back(std::string(currency));
+			//responses can be large, they are streamed
+			cachedResponseAsync(nullptr, req, std::move(key), outputContentType(fmt), std::move(symbols), false,
+					[=, &priceStore, currency = std::string(currency)](ResponseCapture &s) -> Producer {
+				using Point = std::pair<std::uint64_t, double>;
+				constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+				//rows of the join read by one step
+				constexpr std::size_t stepRows = 16384;
+				//state of the response kept between steps
+				struct State {
+					State(ResponseCapture &s, OutputFormat fmt, PriceStore &pmap, const std::vector<std::string> &assets,
+							const std::string &currency, std::uint64_t from, std::uint64_t to, bool fill)
+						:assets(assets),header([&]{
+							std::string h("time");
+							for (const auto &a: assets) h.append(",").append(a);
+							return h;
+						}()),wr(s, fmt, assets.size(), ",\r\n", header)
+						,join(pmap, this->assets, currency, from, to, fill)
+						,frame(assets.size(), std::numeric_limits<double>::quiet_NaN()) {}
+					std::vector<std::string> assets;
+					std::string header;
+					SeriesWriter<ResponseCapture> wr;
+					MatrixJoin<PriceStore> join;
+					std::vector<std::vector<Point> > groups;
+					std::vector<double> frame;
+					std::uint64_t curFrame = 0;
+					bool hasFrame = false;
+					bool joined = false;
+					//next group written (series layout)
+					std::size_t group = 0;
+				};
+				auto st = std::make_shared<State>(s, fmt, priceStore, assets, currency, from, to, fill);
+				if (series) st->groups.resize(n);
+				else st->wr.begin();
+
+				return [=, &s](ResponseCapture &) {
+					State &x = *st;
+					auto emit = [&](std::uint64_t t, const double *v) {
+						if (series) {
+							for (std::size_t i = 0; i < n; i++) {
+								if (!std::isnan(v[i])) x.groups[i].emplace_back(t, v[i]);
+							}
+						} else {
+							s.format([&]{x.wr.push(t, v);});
+						}
+					};
+
+					if (!x.joined) {
+						x.joined = !x.join.read(stepRows, [&](std::uint64_t t, const double *v){
+							if (!tfrm) {
+								emit(t, v);
+								return;
+							}
+							std::uint64_t f = t/tfrm*tfrm;
+							if (x.hasFrame && f != x.curFrame) {
+								emit(x.curFrame, x.frame.data());
+								if (!fill) std::fill(x.frame.begin(), x.frame.end(), nan);
+							}
+							x.hasFrame = true;
+							x.curFrame = f;
+							for (std::size_t i = 0; i < n; i++) {
+								if (!std::isnan(v[i])) x.frame[i] = v[i];
+							}
+						});
+						if (!x.joined) return true;
+						if (x.hasFrame) emit(x.curFrame, x.frame.data());
+						if (!series) {
+							x.wr.end();
+							return false;
+						}
+						s.putCharNB('{');
+					}
+
+					//grouped series are collected in the single pass, then written, one group per step
+					std::size_t i = x.group++;
+					if (i) s.write(",\r\n");
+					json::Value k = x.assets[i];
+					k.serialize([&](char c){s.putCharNB(c);});
+					s.putChar(':');
+					SeriesWriter<ResponseCapture> gw(s, OutputFormat::json, 1, ",");
+					gw.begin();
+					for (const Point &p: x.groups[i]) s.format([&]{gw.push(p.first, &p.second);});
+					gw.end();
+					x.groups[i] = std::vector<Point>();
+					if (x.group < n) return true;
+					s.putCharNB('}');
+					return false;
+				};
+			});
+			return true;
+		} else {
+			return false;
+		}
+	});
+	//statistics are computed from minute prices or daily means, times are in seconds
+	auto withStatsSource = [&](bool daily, auto &&fn) {
+		if (daily) return fn(dailyMean, daysec);
+		else return fn(priceStore, 1);
+	};
+	auto statsNumber = [](double v) {
+		return std::isfinite(v)?json::Value(v):json::Value(nullptr);
+	};
+	server.addPath("/stats/summary")
+		.GET("Public","Summary statistics of prices and log returns of a pair","",{
+				{"asset","query","string","Selected asset"},
+				{"currency","query","string","Selected currency"},
+				{"from","query","int64","From timestamp",{}},
+				{"to","query","int64","To timestamp",{},false},
+				{"source","query","string","minute (default) or daily",{},false}
+		},{
+				{200,"OK",{{"application/json","summary","object","count, first, last, min, max, mean, stddev, return, returns {count, mean, stddev}",{}}}}
+		})
+	.handler([&](PHttpServerRequest &req, const RequestParams &params){
+		if (req->getMethod() != "GET") return false;
+		auto asset=params["asset"];
+		auto currency=params["currency"];
+		auto from=params["from"].getUInt();
+		auto to=params["to"].getUInt();
+		std::string key("stats-summary|");
+		key.append(asset).append("|").append(currency)
+		   .append("|").append(std::to_string(from)).append("|").append(std::to_string(to))
+		   .append("|").append(params["source"]);
+		bool immutable = to && to <= currentTime()/daysec*daysec;
+		bool daily = params["source"] == "daily";
+		cachedResponseAsync(&server.cache, req, std::move(key), "application/json", {std::string(asset), std::string(currency)}, immutable,
+				[=, asset = std::string(asset), currency = std::string(currency)](ResponseCapture &s) -> Producer {
+			return withStatsSource(daily, [&](auto &src, std::uint64_t mult) -> Producer {
+				using Source = std::remove_reference_t<decltype(src)>;
+				//state of the response kept between steps
+				struct State {
+					State(PairReader<Source> &&reader):reader(std::move(reader)) {}
+					PairReader<Source> reader;
+					RunningMoments prices, returns;
+					LogReturns lr;
+					double mn = std::numeric_limits<double>::infinity(), mx = -mn;
+					std::uint64_t firstTime = 0, lastTime = 0;
+					double firstPrice = 0, lastPrice = 0;
+				};
+				auto st = std::make_shared<State>(PairReader<Source>(scanner, src, asset, currency, from/mult, to?(to+mult-1)/mult:0, mult, false));
+				return [st, &s, statsNumber](ResponseCapture &) {
+					State &x = *st;
+					if (x.reader.read([&](std::uint64_t t, double v){
+						if (!x.prices.count()) {
+							x.firstTime = t;
+							x.firstPrice = v;
+						}
+						x.lastTime = t;
+						x.lastPrice = v;
+						x.prices.add(v);
+						x.mn = std::min(x.mn, v);
+						x.mx = std::max(x.mx, v);
+						double r;
+						if (x.lr.push(v, r)) x.returns.add(r);
+					})) return true;
+					json::Object res;
+					res.set("count", x.prices.count());
+					if (x.prices.count()) {
+						res.set("first", {x.firstTime, x.firstPrice});
+						res.set("last", {x.lastTime, x.lastPrice});
+						res.set("min", x.mn);
+						res.set("max", x.mx);
+						res.set("return", statsNumber(std::log(x.lastPrice/x.firstPrice)));
+					}
+					res.set("mean", statsNumber(x.prices.mean()));
+					res.set("stddev", statsNumber(x.prices.stddev()));
+					json::Object rets;
+					rets.set("count", x.returns.count());
+					rets.set("mean", statsNumber(x.returns.mean()));
+					rets.set("stddev", statsNumber(x.returns.stddev()));
+					res.set("returns", rets);
+					json::String txt = json::Value(res).stringify();
+					s.write(txt.str());
+					return false;
+				};
+			});
+		});
+		return true;
+	});
+	server.addPath("/stats/rolling")
+		.GET("Public","Rolling indicator of a pair","",{
+				{"asset","query","string","Selected asset"},
+				{"currency","query","string","Selected currency"},
+				{"from","query","int64","From timestamp",{}},
+				{"to","query","int64","To timestamp",{},false},
+				{"window","query","integer","Count of samples in the window (at least 2)",{}},
+				{"indicator","query","string","sma (default) - moving average, stddev - moving standard deviation of prices, volatility - moving standard deviation of log returns, returns - log returns (no window)",{},false},
+				{"source","query","string","minute (default) or daily",{},false},
+				{"format","query","string","Output format: json, csv, bin, bin-delta (default: according to Accept)",{},false}
+		},{
+				{200,"OK",{{"application/json","series","array","Values of the indicator, first value at the end of the first full window",{
+						{"pair","anyOf","",{
+								{"time","int64","Time in seconds"},
+								{"value","number","Value"}
+						}}
+				}}}},
+				{400,"Invalid window or indicator",{}}
+		})
+	.handler([&](PHttpServerRequest &req, const RequestParams &params){
+		if (req->getMethod() != "GET") return false;
+		auto asset=params["asset"];
+		auto currency=params["currency"];
+		auto from=params["from"].getUInt();
+		auto to=params["to"].getUInt();
+		auto window=params["window"].getUInt();
+		auto indicator=params["indicator"];
+		enum class Indicator {sma, stddev, volatility, returns} ind;
+		if (!indicator.defined || indicator == "sma") ind = Indicator::sma;
+		else if (indicator == "stddev") ind = Indicator::stddev;
+		else if (indicator == "volatility") ind = Indicator::volatility;
+		else if (indicator == "returns") ind = Indicator::returns;
+		else {
+			req->sendErrorPage(400);
+			return true;
+		}
+		if (ind != Indicator::returns && (window < 2 || window > 1000000)) {
+			req->sendErrorPage(400);
+			return true;
+		}
+		auto selFmt = selectOutputFormat(params["format"], req->get("Accept"));
+		if (!selFmt) {
+			req->sendErrorPage(400);
+			return true;
+		}
+		OutputFormat fmt = *selFmt;
+		std::string key("stats-rolling|");
+		key.append(asset).append("|").append(currency)
+		   .append("|").append(std::to_string(from)).append("|").append(std::to_string(to))
+		   .append("|").append(std::to_string(window)).append("|").append(std::to_string(static_cast<int>(ind)))
+		   .append("|").append(params["source"]).append("|").append(std::to_string(static_cast<int>(fmt)));
+		bool immutable = to && to <= currentTime()/daysec*daysec;
+		bool daily = params["source"] == "daily";
+		cachedResponseAsync(&server.cache, req, std::move(key), outputContentType(fmt), {std::string(asset), std::string(currency)}, immutable,
+				[=, asset = std::string(asset), currency = std::string(currency)](ResponseCapture &s) -> Producer {
+			return withStatsSource(daily, [&](auto &src, std::uint64_t mult) -> Producer {
+				using Source = std::remove_reference_t<decltype(src)>;
+				//state of the response kept between steps
+				struct State {
+					State(ResponseCapture &s, OutputFormat fmt, std::size_t window, PairReader<Source> &&reader)
+						:wr(s, fmt, 1, ",\r\n"),rm(window),reader(std::move(reader)) {}
+					SeriesWriter<ResponseCapture> wr;
+					RollingMoments rm;
+					LogReturns lr;
+					PairReader<Source> reader;
+				};
+				auto st = std::make_shared<State>(s, fmt, window, PairReader<Source>(scanner, src, asset, currency, from/mult, to?(to+mult-1)/mult:0, mult, false));
+				st->wr.begin();
+				return [st, &s, ind](ResponseCapture &) {
+					State &x = *st;
+					auto write = [&](std::uint64_t t, double v) {
+						s.format([&]{x.wr.push(t, &v);});
+					};
+					if (x.reader.read([&](std::uint64_t t, double v){
+						double r;
+						switch (ind) {
+						case Indicator::sma:
+							x.rm.add(v);
+							if (x.rm.full()) write(t, x.rm.mean());
+							break;
+						case Indicator::stddev:
+							x.rm.add(v);
+							if (x.rm.full()) write(t, x.rm.stddev());
+							break;
+						case Indicator::volatility:
+							if (!x.lr.push(v, r)) break;
+							x.rm.add(r);
+							if (x.rm.full()) write(t, x.rm.stddev());
+							break;
+						case Indicator::returns:
+							if (x.lr.push(v, r)) write(t, r);
+							break;
+						}
+					})) return true;
+					x.wr.end();
+					return false;
+				};
+			});
+		});
+		return true;
+	});
+	server.addPath("/stats/correlation")
+		.GET("Public","Correlation matrix of log returns of several assets in one currency","",{
+				{"assets","query","string","Comma separated list of assets (max 64)"},
+				{"currency","query","string","Selected currency"},
+				{"from","query","int64","From timestamp",{}},
+				{"to","query","int64","To timestamp",{},false},
+				{"source","query","string","minute (default) or daily",{},false}
+		},{
+				{200,"OK",{{"application/json","correlation","object","assets, volatility (stddev of log returns per asset), samples and correlation (matrices in order of the assets)",{}}}},
+				{400,"Invalid list of assets",{}}
+		})
+	.handler([&](PHttpServerRequest &req, const RequestParams &params){
+		if (req->getMethod() != "GET") return false;
+		std::vector<std::string> assets;
+		std::string list(params["assets"]);
+		for (std::size_t pos = 0; pos <= list.size();) {
+			auto sep = std::min(list.find(',', pos), list.size());
+			if (sep > pos) assets.push_back(list.substr(pos, sep - pos));
+			pos = sep + 1;
+		}
+		//every row updates all pairs
+		if (assets.empty() || assets.size() > 64) {
+			req->sendErrorPage(400);
+			return true;
+		}
+		auto currency=params["currency"];
+		auto from=params["from"].getUInt();
+		auto to=params["to"].getUInt();
+		std::size_t n = assets.size();
+		std::string key("stats-correlation|");
+		key.append(list).append("|").append(currency)
+		   .append("|").append(std::to_string(from)).append("|").append(std::to_string(to))
+		   .append("|").append(params["source"]);
+		bool immutable = to && to <= currentTime()/daysec*daysec;
+		std::vector<std::string> symbols(assets);
+		symbols.push_back(std::string(currency));
+		bool daily = params["source"] == "daily";
+		cachedResponseAsync(&server.cache, req, std::move(key), "application/json", std::move(symbols), immutable,
+				[=, currency = std::string(currency)](ResponseCapture &s) -> Producer {
+			return withStatsSource(daily, [&](auto &src, std::uint64_t mult) -> Producer {
+				using Source = std::remove_reference_t<decltype(src)>;
+				//rows of the join read by one step
+				constexpr std::size_t stepRows = 16384;
+				//state of the response kept between steps
+				struct State {
+					State(Source &src, const std::vector<std::string> &assets, const std::string &currency,
+							std::uint64_t from, std::uint64_t to)
+						:assets(assets),join(src, this->assets, currency, from, to, false)
+						,lr(assets.size()),vol(assets.size()),cov(assets.size()*assets.size())
+						,r(assets.size()),valid(assets.size()) {}
+					std::vector<std::string> assets;
+					//all assets are joined in one pass, the currency is read once
+					MatrixJoin<Source> join;
+					std::vector<LogReturns> lr;
+					std::vector<RunningMoments> vol;
+					//upper triangle, pair (i,j) at i*n+j
+					std::vector<RunningCovariance> cov;
+					std::vector<double> r;
+					std::vector<char> valid;
+				};
+				auto st = std::make_shared<State>(src, assets, currency, from/mult, to?(to+mult-1)/mult:0);
+				return [st, &s, n, statsNumber](ResponseCapture &) {
+					State &x = *st;
+					if (x.join.read(stepRows, [&](std::uint64_t, const double *v){
+						for (std::size_t i = 0; i < n; i++) {
+							if (std::isnan(v[i])) {
+								//return over a gap is not comparable
+								x.lr[i].reset();
+								x.valid[i] = 0;
+							} else {
+								x.valid[i] = x.lr[i].push(v[i], x.r[i]);
+								if (x.valid[i]) x.vol[i].add(x.r[i]);
+							}
+						}
+						for (std::size_t i = 0; i < n; i++) if (x.valid[i]) {
+							for (std::size_t j = i+1; j < n; j++) if (x.valid[j]) x.cov[i*n+j].add(x.r[i], x.r[j]);
+						}
+					})) return true;
+					json::Array names, volatility, samples, corr;
+					for (std::size_t i = 0; i < n; i++) {
+						names.push_back(x.assets[i]);
+						volatility.push_back(statsNumber(x.vol[i].stddev()));
+						json::Array srow, crow;
+						for (std::size_t j = 0; j < n; j++) {
+							if (i == j) {
+								srow.push_back(x.vol[i].count());
+								crow.push_back(x.vol[i].count() > 1?json::Value(1.0):json::Value(nullptr));
+							} else {
+								const RunningCovariance &c = x.cov[std::min(i,j)*n+std::max(i,j)];
+								srow.push_back(c.count());
+								crow.push_back(statsNumber(c.correlation()));
+							}
+						}
+						samples.push_back(srow);
+						corr.push_back(crow);
+					}
+					json::Object res;
+					res.set("assets", names);
+					res.set("volatility", volatility);
+					res.set("samples", samples);
+					res.set("correlation", corr);
+					json::String txt = json::Value(res).stringify();
+					s.write(txt.str());
+					return false;
+				};
+			});
+		});
+		return true;
+	});
+	auto historyTolerance = server_section["history_tolerance"];
+	std::uint64_t defaultTolerance = historyTolerance.defined()?historyTolerance.getUInt():3600;
 	server.addPath("/history/{time}")
-		.GET("Public","Retrieve one page of the history","",{
+		.GET("Public","Retrieve latest prices at or before given time","",{
 				{"time","path","Timestamp","uint64",{}},
-				{"currency","query","Specity base currency (optional)","string",{}, false}
+				{"currency","query","Specity base currency (optional)","string",{}, false},
+				{"tolerance","query","Max age of a price in seconds (optional, 0 - exact minute)","uint64",{}, false}
 		},{
 				{200,"OK",{{"application/json","snapshot","assoc","History snapshot",{
 								{"symbol","string","SymbolName"},
@@ -413,37 +1373,55 @@ int main(int argc, char **argv) {
 		if (req->getMethod() == "GET") {
 			auto tm = params["time"];
 			if (!tm.defined) return false;
-			json::Value at(tm.getUInt());
+			std::uint64_t attm = tm.getUInt();
+			auto tol = params["tolerance"];
+			std::uint64_t tolerance = tol.defined?tol.getUInt():defaultTolerance;
+			std::uint64_t lowest = attm > tolerance?attm - tolerance:0;
 			bool comma = false;
 			double divider = 1;
 			auto cur = params["currency"];
+			//recent minutes are in the memory
+			std::uint64_t minute = attm/60*60;
+			auto snap = minute >= lowest?catalog.snapshot(minute):nullptr;
+			auto snapLookup = [&](std::string_view symbol, double &price) {
+				if (!snap) return false;
+				auto iter = std::lower_bound(snap->begin(), snap->end(), symbol, [](const auto &a, std::string_view b){
+					return a.first < b;
+				});
+				if (iter == snap->end() || iter->first != symbol) return false;
+				price = iter->second;
+				return true;
+			};
+			auto asOf = [&](std::string_view symbol, double &price) {
+				std::uint64_t t;
+				return snapLookup(symbol, price) || priceStore.asOf(symbol, attm, tolerance, t, price);
+			};
 			if (cur.defined) {
-				json::Value price = pmap.lookup({cur, at});
-				if (!price.defined()) {
+				if (!asOf(cur, divider)) {
 					req->sendErrorPage(404);
 					return true;
 				}
-				divider = price.getNumber();
 			}
 
 			req->setContentType("application/json");;
 			Stream s = req->send();
 			s.putCharNB('{');
 
-			for (auto iter = totalRange.scan(); iter.next();) {
-				auto symbol = iter.key();
-				json::Value v = pmap.lookup(json::Value({symbol,at}));
-				if (v.defined()) {
-					if (comma) {
-						s.write(",\r\n");
-					} else {
-						comma = true;
-					}
-					v = json::Value(v.getNumber()/divider);
-					symbol.serialize([&](char c){s.putCharNB(c);});
-					s.putChar(':');
-					v.serialize([&](char c){s.putCharNB(c);});
+			auto emit = [&](std::string_view symbol, double price) {
+				if (comma) {
+					s.write(",\r\n");
+				} else {
+					comma = true;
 				}
+				json::Value(symbol).serialize([&](char c){s.putCharNB(c);});
+				s.putChar(':');
+				json::Value(price/divider).serialize([&](char c){s.putCharNB(c);});
+			};
+
+			//only symbols having data within the tolerance, lookups are made in the key order
+			for (const auto &symbol: catalog.activeIn(lowest, attm)) {
+				double price;
+				if (asOf(symbol, price)) emit(symbol, price);
 			}
 			s.putCharNB('}');
 			s.flush();
@@ -465,14 +1443,115 @@ int main(int argc, char **argv) {
 		}
 	});
 
-	using SymbolMap=std::map<std::string, std::pair<double,unsigned int> >;
+	JobManager jobs(std::max<unsigned int>(1, jobs_section["threads"].getUInt()), jobs_section["io_rate"].getUInt());
+	auto sendJob = [](PHttpServerRequest &req, std::uint64_t id) {
+		json::Object ret;
+		ret.set("job", id);
+		json::String data = json::Value(ret).stringify();
+		req->setStatus(202);
+		req->setContentType("application/json");
+		req->send(data.str());
+	};
 
-	SymbolMap symbolMap;
-	std::mutex symbolMapLock;
+	//remaining days are rebuilt in background, readers rebuild their symbols on demand
+	if (!dailyRebuild.current()) {
+		jobs.start("view-rebuild", dailyRebuild.pending(), [&](JobContext &ctx, const std::string &symbol) -> json::Value {
+			return dailyRebuild.rebuild(symbol, &ctx);
+		});
+	}
+
+	//old minutes are rolled up once a day
+	auto startRetention = [&](std::uint64_t today) {
+		if (!retention.due(today)) return;
+		std::vector<std::string> shards;
+		catalog.forEach([&](const std::string &symbol, const SymbolCatalog::Info &) {
+			shards.push_back(symbol);
+		});
+		jobs.start("retention", std::move(shards), [&, today](JobContext &ctx, const std::string &symbol) -> json::Value {
+			std::size_t days = retention.run(ctx, symbol, today);
+			if (days) historyChanged({symbol});
+			return days;
+		});
+	};
+	//closed days are sealed in background, old data are rolled up after that
+	auto startMaintenance = [&](std::uint64_t today) {
+		if (!priceStore.sealDue(today)) {
+			startRetention(today);
+			return;
+		}
+		std::vector<std::string> shards;
+		catalog.forEach([&](const std::string &symbol, const SymbolCatalog::Info &) {
+			shards.push_back(symbol);
+		});
+		jobs.start("seal", std::move(shards), [&, today](JobContext &ctx, const std::string &symbol) -> json::Value {
+			return priceStore.seal(writer, symbol, today, [&](std::size_t minutes) {
+				ctx.throttle(minutes);
+				return !ctx.cancelled();
+			});
+		}, [&, today]{startRetention(today);});
+	};
+	startMaintenance(currentTime()/daysec);
+
+	IngestPipeline ingest;
+	NormalizerRegistry normalizers;
+	{
+		auto collector_section = app.config["collector"];
+		auto split = [](std::string_view list) {
+			std::vector<std::string> out;
+			while (!list.empty()) {
+				auto sep = list.find_first_of(", ");
+				auto item = list.substr(0, sep);
+				if (!item.empty()) out.emplace_back(item);
+				list = sep == list.npos?std::string_view():list.substr(sep+1);
+			}
+			return out;
+		};
+		for (const auto &name: split(collector_section["sources"].getString())) {
+			auto section = app.config["collector."+name];
+			RuleAdapter::Rules rules;
+			rules.rows = section["rows"].getString();
+			if (section["symbol"].defined()) rules.symbol = section["symbol"].getString();
+			if (section["price"].defined()) rules.price = section["price"].getString();
+			rules.quoteField = section["quote_field"].getString();
+			rules.quote = section["quote"].getString();
+			rules.prefix = section["prefix"].getString();
+			rules.suffixes = split(section["suffixes"].getString());
+			if (section["lowercase"].defined()) rules.lowercase = section["lowercase"].getBool();
+			rules.fallback = section["fallback"].getBool();
+			rules.mergeQuotes = section["merge_quotes"].getBool();
+			normalizers.add(name, std::make_shared<RuleAdapter>(std::move(rules)));
+			logNote("Collector source '$1' registered", name);
+		}
+	}
+
+	auto maxLive = server_section["live_max_clients"];
+	LiveFeed liveFeed(maxLive.defined()?maxLive.getUInt():1000);
+	metrics.gauge("live_subscribers", "", [&]{return static_cast<double>(liveFeed.subscribers());});
+	metrics.gauge("live_frames_sent", "", [&]{return static_cast<double>(liveFeed.sent());});
+	metrics.gauge("live_frames_skipped", "", [&]{return static_cast<double>(liveFeed.skipped());});
+
+	Histogram &commitLatency = metrics.histogram("collector_commit_seconds", "");
+	Counter &commitCount = metrics.counter("collector_committed_prices_total", "");
+	auto commitPrices = [&](std::uint64_t curTime, IngestPipeline::Result &&prices) {
+		auto start = std::chrono::steady_clock::now();
+		commitCount.add(prices.size());
+		Batch batch;
+		std::set<std::string, std::less<> > symbols;
+		for (const auto &m: prices) {
+			pmap.set(batch, {m.first, curTime}, m.second);
+			symbols.insert(symbols.end(), m.first);
+		}
+		writer.commit(batch);
+		catalog.commit(curTime, std::move(prices));
+		startMaintenance(curTime/daysec);
+		server.cache.invalidate(symbols, false);
+		liveFeed.publish(curTime, catalog.snapshot(curTime));
+		commitLatency.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	};
 
 
 	server.addPath("/clean")
-	.POST("Admin","Remove invalid values","",{},"Request has no body",{},{{200,"OK",{}}})
+	.POST("Admin","Remove invalid values (runs as a job, GET only reports the values)","",{},"Request has no body",{},{{202,"Accepted",{}}})
 	.handler([&](PHttpServerRequest &req, RequestParams vpath) {
 		if (!checkHost(req->getHost())) {
 			req->sendErrorPage(403);return true;
@@ -481,46 +1560,87 @@ int main(int argc, char **argv) {
 		if (req->getMethod() == "POST") {
 			store = true;
 		}
-		Batch batch;
-		req->setContentType("text/plain");
-		Stream s =req->send();
-		json::Value symbol;
-		json::Value chkTime;
-		double a = 0 ,b = 0,c = 0;
-		auto iter = pmap.scan();
-		while (iter.next()) {
-			auto key = iter.key();
-			if (key[0] != symbol) {
-				symbol = key[0];
-				chkTime = nullptr;
-				a=b=c=0;
-				s.writeNB("# Checking symbol: ");
-				s.writeNB(symbol.getString());
-				s.writeNB("\r\n");
-				s.flush();
-				if (store) db.commitBatch(batch);
-			}
-			a = b;
-			b = c;
-			c = iter.value().getNumber();
-			auto tm = key[1];
-			if (a != 0) {
-				double avgb = sqrt(a*c);
-				double df1 = std::abs(avgb - b)/b;
-				double df2 = std::abs(a-c)/b;
-				if (df2*3 < df1 && df1>0.005) {
-					char buff[1000];
-					snprintf(buff,sizeof(buff),"%s %llu %g %g %g\r\n",symbol.getString().data, chkTime.getUIntLong(), a, b, c);
-					s.write(buff);
-					pmap.set(batch, {symbol, chkTime}, avgb);
+		std::vector<std::string> shards;
+		catalog.forEach([&](const std::string &symbol, const SymbolCatalog::Info &) {
+			shards.push_back(symbol);
+		});
+		auto id = jobs.start(store?"clean":"clean-check", std::move(shards), [&, store](JobContext &ctx, const std::string &symbol) -> json::Value {
+			Batch batch;
+			json::Array fixes;
+			std::uint64_t chkTime = 0;
+			double a = 0 ,b = 0,c = 0;
+			std::size_t ops = 0;
+			//only minutes are checked and fixed, a fix inside rolled up data would be hidden by the candles
+			auto iter = priceStore.minuteRange({symbol, priceStore.rollupEnd(symbol)},{symbol, std::numeric_limits<std::uint64_t>::max()});
+			while (iter.next()) {
+				if (++ops % 10000 == 0) {
+					if (ctx.cancelled()) break;
+					ctx.throttle(10000);
 				}
+				a = b;
+				b = c;
+				c = iter.price();
+				auto tm = iter.time();
+				if (a != 0) {
+					double avgb = sqrt(a*c);
+					double df1 = std::abs(avgb - b)/b;
+					double df2 = std::abs(a-c)/b;
+					if (df2*3 < df1 && df1>0.005) {
+						fixes.push_back({chkTime, a, b, c});
+						pmap.set(batch, {symbol, chkTime}, avgb);
+					}
+				}
+				chkTime = tm;
 			}
-			chkTime = tm;
-		}
-		if (store) db.commitBatch(batch);
+			if (fixes.size() == 0) return json::Value();
+			if (store) {
+				writer.commit(batch);
+				historyChanged({symbol});
+				catalog.clearSnapshots();
+			}
+			return json::Value(fixes);
+		});
+		sendJob(req, id);
 		return true;
 	});
 
+	server.addPath("/jobs", [&](PHttpServerRequest &req, std::string_view vpath){
+		auto pos = vpath.find('?');
+		if (pos != vpath.npos) {
+			vpath = vpath.substr(0,pos);
+		}
+		if (vpath.empty() || vpath == "/") {
+			if (req->getMethod() != "GET") return false;
+			req->setContentType("application/json");
+			req->send(jobs.list().stringify().str());
+			return true;
+		}
+		std::uint64_t id = std::strtoull(std::string(vpath.substr(1)).c_str(), nullptr, 10);
+		if (req->getMethod() == "GET") {
+			json::Value st = jobs.status(id);
+			if (!st.defined()) {
+				req->sendErrorPage(404);
+			} else {
+				req->setContentType("application/json");
+				req->send(st.stringify().str());
+			}
+			return true;
+		} else if (req->getMethod() == "DELETE") {
+			if (!checkHost(req->getHost())) {
+				req->sendErrorPage(403);return true;
+			}
+			if (jobs.cancel(id)) {
+				req->setStatus(202);
+				req->send("");
+			} else {
+				req->sendErrorPage(404);
+			}
+			return true;
+		} else {
+			return false;
+		}
+	});
+
 	server.addPath("/collector", [&](PHttpServerRequest &req, std::string_view vpath){
 		if (req->getMethod() == "POST") {
 			if (!checkHost(req->getHost())) {
@@ -528,175 +1648,175 @@ int main(int argc, char **argv) {
 			}
 			auto curTime = ((std::chrono::duration_cast<std::chrono::seconds>(
 					std::chrono::system_clock::now().time_since_epoch()).count()+30)/60)*60;
-			json::Value body;
+			if (vpath == "/commit") {
+				auto prices = ingest.commit(curTime);
+				req->log(userver::LogLevel::progress,"Commit ", prices.size(), " entries (timestamp: ",curTime,")");
+				commitPrices(curTime, std::move(prices));
+				req->setStatus(202);
+				req->send("");
+				return true;
+			}
+			std::vector<NormalizerRegistry::Binding> bindings;
+			if (vpath.empty()) {
+				//legacy combined body [cryptowatch, ftx], committed immediately
+				bindings.push_back({"0.result.rows", normalizers.find("cryptowatch")});
+				bindings.push_back({"1.result", normalizers.find("ftx")});
+			} else {
+				const SourceAdapter *adapter = normalizers.find(vpath.substr(1));
+				if (adapter == nullptr) {
+					req->sendErrorPage(404);
+					return true;
+				}
+				bindings.push_back({std::string(adapter->rowsPath()), adapter});
+			}
+			if (vpath.empty()) ingest.clear();
+			IngestSink sink(ingest, vpath.empty());
 			if (req->isBodyAvailable()) {
 				Stream b = req->getBody();
-				body = json::Value::parse([&]()->int {
+				NormalizerRegistry::parse([&]()->int {
 					return b.getChar();
-				});
+				}, bindings, sink);
 			}
-			std::unique_lock _(symbolMapLock);
+			sink.finish();
 			if (vpath.empty()) {
-				symbolMap.clear();
-				auto cryptowatch_result = body[0]["result"];
-				auto ftx_result = body[1]["result"];
-				for (json::Value x: cryptowatch_result["rows"]) {
-					 auto symbol = x["symbol"].toString();
-					 auto price = x["price"].getNumber();
-					 if (price && std::isfinite(price)) {
-						 auto res = symbolMap.emplace(symbol.str(), std::pair{price,1} );
-						 if (!res.second) {
-							 res.first->second.first += price;
-							 res.first->second.second ++;
-						 }
-
-					 }
-				}
-				for (json::Value x: ftx_result) {
-					bool skip = false;
-					double price = x["price"].getNumber();
-					std::string symbol;
-					if (x["type"].getString() == "future") {
-						symbol=x["name"].getString();
-						while (!symbol.empty() && symbol.back()>='0' && symbol.back()<='9')  {
-							symbol.pop_back();
-						}
-						if (!symbol.empty() && symbol.back()=='-') {
-							symbol.append("fut");
-						} else {
-							symbol=x["name"].getString();
-						}
-					} else {
-						symbol=x["baseCurrency"].getString();
-						skip=x["quoteCurrency"].getString() != "USD";
-					}
-					std::transform(symbol.begin(), symbol.end(),symbol.begin(),[](char c){return std::tolower(c);});
-
-				  if (!skip && std::isfinite(price) && price) {
-						 auto res = symbolMap.emplace(symbol, std::pair{price,1} );
-						 if (!res.second) {
-							 res.first->second.first += price;
-							 res.first->second.second ++;
-						 }
-				  }
-				}
-				Batch batch;
-				for (const auto &m: symbolMap) {
-					pmap.set(batch, {m.first, curTime}, m.second.first/m.second.second);
-				}
-				db.commitBatch(batch);
+				commitPrices(curTime, ingest.commit(curTime));
 				req->setStatus(202);
 				req->send("ok");
-				return true;
-			} else if (vpath == "/commit") {
-				Batch batch;
-				for (const auto &m: symbolMap) {
-					pmap.set(batch, {m.first, curTime}, m.second.first/std::max<double>(1,m.second.second));
-				}
-				db.commitBatch(batch);
-				req->log(userver::LogLevel::progress,"Commit ", symbolMap.size(), " entries (timestamp: ",curTime,")");
-				symbolMap.clear();
-				req->setStatus(202);
-				req->send("");
-				return true;
-			} else if (vpath == "/cryptowatch") {
-				json::Value cryptowatch_result = body["result"];
-				for (json::Value x: cryptowatch_result["rows"]) {
-					 auto symbol = x["symbol"].toString();
-					 auto price = x["price"].getNumber();
-					 if (price && std::isfinite(price)) {
-						 symbolMap.emplace(symbol.str(), std::pair{price,0} );
-					 }
-				}
+			} else {
 				req->setStatus(202);
 				req->send("");
-				return true;
-			} else if (vpath == "/ftx") {
-				auto ftx_result = body["result"];
-				for (json::Value x: ftx_result) {
-					bool skip = false;
-					double price = x["price"].getNumber();
-					std::string symbol;
-					if (x["type"].getString() == "future") {
-						symbol=x["name"].getString();
-						while (!symbol.empty() && symbol.back()>='0' && symbol.back()<='9')  {
-							symbol.pop_back();
-						}
-						if (!symbol.empty() && symbol.back()=='-') {
-							symbol.append("fut");
-						} else {
-							symbol=x["name"].getString();
-						}
-					} else {
-						symbol=x["baseCurrency"].getString();
-						skip=x["quoteCurrency"].getString() != "USD";
-					}
-					std::transform(symbol.begin(), symbol.end(),symbol.begin(),[](char c){return std::tolower(c);});
+			}
+			return true;
+		} else {
+			return false;
+		}
+	});
+	//reads minute and daily prices of the symbol for the export
+	auto readExport = [&](JobContext &ctx, const std::string &symbol, std::uint64_t fromDay, std::uint64_t toDay,
+			ExportWriter::Series &minutes, ExportWriter::Series &daily) {
+		auto iter = priceStore.range({symbol, fromDay*daysec},{symbol, toDay*daysec});
+		while (iter.next()) {
+			minutes.times.push_back(static_cast<std::uint32_t>(iter.time()));
+			minutes.prices.push_back(iter.price());
+		}
+		auto diter = dailyPrice.range({symbol, fromDay},{symbol, toDay});
+		while (diter.next()) {
+			daily.times.push_back(static_cast<std::uint32_t>(diter.key(1).getUInt()*daysec));
+			daily.prices.push_back(DailyRecord::fromJson(diter.value()).mean);
+		}
+		ctx.throttle(minutes.times.size() + daily.times.size());
+	};
+	//existing files are reused, they are dropped when their data change
+	auto writeExport = [&](const std::string &name, auto &&fill) -> json::Value {
+		std::string fname = exportPath + "/" + name;
+		json::Object res;
+		res.set("file", name);
+		std::error_code ec;
+		if (std::filesystem::exists(fname, ec)) {
+			res.set("size", static_cast<std::uint64_t>(std::filesystem::file_size(fname, ec)));
+			res.set("reused", true);
+		} else {
+			std::uint64_t gen = exportGeneration;
+			res.set("size", fill(fname));
+			res.set("reused", false);
+			//data changed during the export, the file could miss the change
+			if (gen != exportGeneration) {
+				std::filesystem::remove(fname, ec);
+				throw std::runtime_error("Data changed during the export, export discarded");
+			}
+		}
+		return res;
+	};
 
-				  if (!skip && std::isfinite(price) && price) {
-						 auto res = symbolMap.emplace(symbol, std::pair{price,1} );
-						 if (!res.second) updatePrice(res.first->second, price);
-				  }
-				}
-				req->setStatus(202);
-				req->send("");
-				return true;
-			} else if (vpath == "/bitfinex") {
-				for (json::Value row: body) {
-					auto symbol = row[0].getString();
-					if (symbol[0] == 't') {
-						auto splt = symbol.substr(1).split(":");
-						auto asset = splt();
-						auto currency = splt();
-						if (currency.empty()) {
-							currency = asset.substr(3);
-							asset = asset.substr(0,3);
-						}
-						if (currency == "USD") {
-							double price = row[7].getNumber();
-							std::string symbol = asset;
-							std::transform(symbol.begin(), symbol.end(),symbol.begin(),[](char c){return std::tolower(c);});
-							auto res = symbolMap.emplace(symbol, std::pair{price,1} );
-							if (!res.second) updatePrice(res.first->second, price);
-						}
-					}
+	server.addPath("/export", [&](PHttpServerRequest &req, std::string_view vpath){
+		if (exportPath.empty()) return false;
+		QueryParser qp(vpath);
+		auto pos = vpath.find('?');
+		if (pos != vpath.npos) {
+			vpath = vpath.substr(0,pos);
+		}
+		if (vpath.empty() || vpath == "/") {
+			if (req->getMethod() == "GET") {
+				json::Array files;
+				std::error_code ec;
+				for (const auto &e: std::filesystem::directory_iterator(exportPath, ec)) {
+					if (e.path().extension() != ".mmpx") continue;
+					json::Object f;
+					f.set("file", e.path().filename().string());
+					f.set("size", static_cast<std::uint64_t>(e.file_size(ec)));
+					files.push_back(f);
 				}
-				req->setStatus(202);
-				req->send("");
+				req->setContentType("application/json");
+				req->send(json::Value(files).stringify().str());
 				return true;
-			} else if (vpath == "/binance") {
-				SymbolMap smap;
-				std::string symbol;
-				for (json::Value row: body) {
-					symbol.clear();
-					auto symb = row["symbol"].getString();
-					if (symb.endsWith("USDT")) {
-						symbol = symb.substr(0, symb.length-4);
-					} else if (symb.endsWith("BUSD")) {
-						symbol = symb.substr(0, symb.length-4);
-					}
-					double price = row["price"].getNumber();
-					if (!symbol.empty()) {
-						std::transform(symbol.begin(), symbol.end(),symbol.begin(),[](char c){return std::tolower(c);});
-						auto res = smap.emplace(symbol,std::pair{price,1});
-						if (!res.second) updatePrice(res.first->second, price);
-					}
-				}
-				for (const auto &row: smap) {
-					double price = row.second.first/row.second.second;
-					auto res = symbolMap.emplace(row.first, std::pair{price,1} );
-					if (!res.second) updatePrice(res.first->second, price);
+			}
+			if (req->getMethod() != "POST") return false;
+			if (!checkHost(req->getHost())) {
+				req->sendErrorPage(403);return true;
+			}
+			std::uint64_t today = currentTime()/daysec;
+			std::string symbol(qp["symbol"]);
+			//range is clamped to days with data
+			std::uint64_t firstDay = std::numeric_limits<std::uint64_t>::max();
+			bool known = false;
+			catalog.forEach([&](const std::string &s, const SymbolCatalog::Info &nfo) {
+				if (symbol.empty() || s == symbol) {
+					firstDay = std::min(firstDay, nfo.firstDay);
+					known = true;
 				}
-				req->setStatus(202);
-				req->send("");
-				return true;
+			});
+			if (!known || symbol.size() > exportfmt::maxNameLength) {
+				req->sendErrorPage(404);return true;
+			}
+			std::uint64_t fromDay = std::max(firstDay, qp["from"].getUInt()/daysec);
+			//only finished days are exported
+			std::uint64_t toDay = std::min(today, qp["to"].defined?(qp["to"].getUInt()+daysec-1)/daysec:today);
+			std::filesystem::create_directories(exportPath);
+			std::vector<std::string> shards;
+			std::uint64_t id;
+			if (symbol.empty()) {
+				//one file per day, all symbols
+				for (std::uint64_t d = fromDay; d < toDay; d++) shards.push_back(std::to_string(d));
+				id = jobs.start("export", std::move(shards), [&](JobContext &ctx, const std::string &shard) -> json::Value {
+					std::uint64_t day = std::strtoull(shard.c_str(), nullptr, 10);
+					return writeExport("day-"+shard+".mmpx", [&](const std::string &fname) {
+						std::vector<std::string> symbols;
+						catalog.forEach([&](const std::string &symbol, const SymbolCatalog::Info &nfo) {
+							if (nfo.firstDay <= day && nfo.lastDay >= day) symbols.push_back(symbol);
+						});
+						ExportWriter wr(day*daysec, (day+1)*daysec);
+						for (const auto &symbol: symbols) {
+							if (ctx.cancelled()) throw std::runtime_error("cancelled");
+							ExportWriter::Series minutes, daily;
+							readExport(ctx, symbol, day, day+1, minutes, daily);
+							if (!minutes.times.empty()) wr.add(symbol, std::move(minutes), std::move(daily));
+						}
+						return wr.write(fname);
+					});
+				});
 			} else {
-				req->sendErrorPage(404);
-				return true;
+				//one file of the symbol
+				shards.push_back(symbol);
+				id = jobs.start("export", std::move(shards), [&, fromDay, toDay](JobContext &ctx, const std::string &symbol) -> json::Value {
+					return writeExport(symbol+"-"+std::to_string(fromDay)+"-"+std::to_string(toDay)+".mmpx", [&](const std::string &fname) {
+						ExportWriter wr(fromDay*daysec, toDay*daysec);
+						ExportWriter::Series minutes, daily;
+						readExport(ctx, symbol, fromDay, toDay, minutes, daily);
+						wr.add(symbol, std::move(minutes), std::move(daily));
+						return wr.write(fname);
+					});
+				});
 			}
-		} else {
-			return false;
+			sendJob(req, id);
+			return true;
 		}
+		if (req->getMethod() != "GET") return false;
+		std::string_view name = vpath.substr(1);
+		if (name.find('/') != name.npos || name.find("..") != name.npos) {
+			req->sendErrorPage(404);return true;
+		}
+		//served by sendfile, clients can map the downloaded file directly
+		return req->sendFile(std::move(req), exportPath + "/" + std::string(name));
 	});
 	server.addPath("/purge", [&](PHttpServerRequest &req, std::string_view vpath){
 	        if (req->getMethod() == "POST") {
@@ -707,17 +1827,21 @@ int main(int argc, char **argv) {
                 auto body = json::Value::parse([&]()->int {
                     return b.getChar();
                 });
-                json::Object ret;
-                Batch batch;
-                for (json::Value item: body) {
-                    std::string_view symbol = item.getString();
-
+                std::vector<std::string> shards;
+                for (json::Value item: body) shards.push_back(item.getString());
+                auto id = jobs.start("purge", std::move(shards), [&](JobContext &ctx, const std::string &symbol) -> json::Value {
+                    Batch batch;
                     std::size_t sz = 0;
+                    //cancel is accepted only before the shard starts, a half purged symbol would stay listed
                     {
                         auto iter = pmap.range({symbol,0}, {symbol, std::numeric_limits<std::uint64_t>::max()});
                         while (iter.next()) {
                             pmap.erase(batch, iter.key());
-                            ++sz;
+                            if (++sz % 10000 == 0) {
+                                writer.commit(batch);
+                                batch.Clear();
+                                ctx.throttle(10000);
+                            }
                         }
                     }
                     {
@@ -726,34 +1850,74 @@ int main(int argc, char **argv) {
                             dailyPrice.erase(batch, iter.key());
                         }
                     }
+                    priceStore.erase(batch, symbol);
+                    ohlcViews.erase(batch, symbol);
                     totalRange.erase(batch, symbol);
-                    db.commitBatch(batch);
-                    batch.Clear();
-                    ret.set(symbol, sz);
-                }
-                json::String data = json::Value(ret).stringify();
-                req->setStatus(200);
-                req->setContentType("application/json");
-                req->send(data.str());
+                    writer.commit(batch);
+                    historyChanged({symbol});
+                    catalog.erase(symbol);
+                    return sz;
+                });
+                sendJob(req, id);
                 return true;
 
 	        } else {
 	            return false;
 	        }
 	});
+	metrics.gauge("response_cache_hits", "", [&]{return static_cast<double>(server.cache.getStats().hits);});
+	metrics.gauge("response_cache_misses", "", [&]{return static_cast<double>(server.cache.getStats().misses);});
+	metrics.gauge("response_cache_bytes", "", [&]{return static_cast<double>(server.cache.getStats().bytes);});
+	metrics.gauge("response_cache_entries", "", [&]{return static_cast<double>(server.cache.getStats().entries);});
+	//LevelDB doesn't count hits of the block cache, only its usage is reported
+	metrics.gauge("leveldb_block_cache_bytes", "", [cache = cfg.block_cache]{return static_cast<double>(cache->TotalCharge());});
+
+	server.addPath("/live")
+		.GET("Public","Live prices (Server-Sent Events), an event is sent after every commit","",{
+				{"symbols","query","string","Comma separated list of symbols quoted in usd (default: all symbols)",{},false},
+				{"pairs","query","string","Comma separated list of pairs asset/currency",{},false}
+		},{
+				{200,"OK",{{"text/event-stream","prices","object","Event data",{
+						{"time","int64","Time of the commit"},
+						{"prices","assoc","Prices",{
+								{"price","number","Price"}
+						}}
+				}}}},
+				{503,"Too many subscribers",{}}
+		})
+	.handler([&](PHttpServerRequest &req, const RequestParams &params){
+		if (req->getMethod() == "GET") {
+			std::string symbols(params["symbols"]);
+			std::string pairs(params["pairs"]);
+			if (!liveFeed.subscribe(req, LiveFeed::Subscription::parse(symbols, pairs))) {
+				req->sendErrorPage(503);
+			}
+			return true;
+		} else {
+			return false;
+		}
+	});
+
+	server.addPath("/metrics",[&](PHttpServerRequest &req, std::string_view ){
+		if (req->getMethod() == "GET") {
+			req->setContentType("text/plain; version=0.0.4");
+			req->send(metrics.exposition());
+			return true;
+		} else {
+			return false;
+		}
+	});
 	server.addPath("/compact",[&](PHttpServerRequest &req, std::string_view ){
 		if (req->getMethod()=="POST" ) {
 			if (!checkHost(req->getHost())) {
 				req->sendErrorPage(403);return true;
 			}
-			req->setStatus(202);
-			req->setContentType("text/plain");
-			Stream s = req->send();
-			s.write("Started\r\n");
-			s.flush();
-			db.compact();
-			s.write("Finished\r\n");
-			s.flush();
+			//compaction takes long, it runs as a job (status in /jobs/<id>)
+			auto id = jobs.start("compact", {"db"}, [&](JobContext &, const std::string &) -> json::Value {
+				db.compact();
+				return true;
+			});
+			sendJob(req, id);
 			return true;
 		} else {
 			return false;
@@ -774,6 +1938,26 @@ int main(int argc, char **argv) {
 
 	server.addSwagBrowser("/swagger");
 
+	auto shardDays = server_section["scan_shard_days"];
+	auto scanParallel = server_section["scan_parallel"].getUInt();
+	if (scanParallel > 1) {
+		auto scanThreads = server_section["scan_threads"];
+		unsigned int threads = scanThreads.defined()?scanThreads.getUInt():std::max(std::thread::hardware_concurrency(), 1U);
+		//helper which can't be queued is not needed, the scan produces the shard itself
+		scans.start(threads, 2*threads);
+		scanner = ParallelScan([](std::function<void()> &&fn) {
+			return scans.run(std::move(fn));
+		}, scanParallel, std::max<std::uint64_t>(1, shardDays.defined()?shardDays.getUInt():30)*daysec);
+	}
+
+	auto streamThreads = server_section["stream_threads"];
+	auto streamQueue = server_section["stream_queue"];
+	streams.start(streamThreads.defined()?streamThreads.getUInt():8, streamQueue.defined()?streamQueue.getUInt():256);
+	metrics.gauge("stream_active", "", []{return static_cast<double>(streams.active());});
+	metrics.gauge("stream_queued", "", []{return static_cast<double>(streams.queued());});
+	metrics.gauge("stream_rejected", "", []{return static_cast<double>(streams.rejected());});
+	metrics.gauge("stream_aborted", "", []{return static_cast<double>(streams.aborted());});
+
 	server.start(NetAddr::fromString(server_section.mandatory["listen"].getString(), "3456"),
 			userver::AsyncProviderConfig{
 	            1,
@@ -785,6 +1969,8 @@ int main(int argc, char **argv) {
 	server.stopOnSignal();
 	server.runAsWorker();
 	server.stop();
+	streams.stop();
+	scans.stop();
 	logNote("---- STOP ----");
 
 
@@ -0,0 +1,208 @@
+/*
+ * matrix.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_MATRIX_H_
+#define SRC_MAIN_MATRIX_H_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "merge_join.h"
+
+///Joins prices of several assets quoted in one currency on a shared time axis
+/**
+ * The currency series is read only once, all assets are joined against it in a single
+ * pass. Rows are emitted at times of the currency series, or at union of times of the assets
+ * when the currency is usd. Rows without any price are skipped. The join ends, when all
+ * assets (or the currency) are exhausted.
+ *
+ * Iterators of assets, which lag behind by more than mergeJoinSeekThreshold steps,
+ * are reopened at the current time (except in the fill forward mode, which needs the last
+ * price before the current time)
+ *
+ * The state of the join is kept in the object, rows are read in parts by read()
+ *
+ * @tparam Source source of minute prices
+ */
+template<typename Source>
+class MatrixJoin {
+public:
+	///Construct join
+	/**
+	 * @param pmap source of minute prices
+	 * @param assets list of assets ("usd" can be included), must stay valid
+	 * @param currency currency
+	 * @param from first time
+	 * @param to end time, 0 - no limit
+	 * @param fillForward missing prices are filled with last known price of the asset
+	 */
+	MatrixJoin(Source &pmap, const std::vector<std::string> &assets, std::string currency,
+			std::uint64_t from, std::uint64_t to, bool fillForward);
+
+	///Reads next rows
+	/**
+	 * @param count approximate count of rows
+	 * @param out function(std::uint64_t time, const double *values) - prices of the assets
+	 *   in order of the list, NaN - missing price
+	 * @retval true more rows can follow
+	 * @retval false join is complete
+	 */
+	template<typename Fn>
+	bool read(std::size_t count, Fn &&out);
+
+protected:
+	using Iter = decltype(std::declval<Source &>().range({std::string_view(), 0},{std::string_view(), 0}));
+
+	struct Column {
+		std::string_view symbol;
+		std::optional<Iter> iter;
+		bool ok = false;
+		std::uint64_t t = 0;
+		//last price of the asset in usd (fill forward)
+		double last = std::numeric_limits<double>::quiet_NaN();
+	};
+
+	Source &pmap;
+	std::string currency;
+	std::uint64_t from;
+	std::uint64_t to;
+	bool fillForward;
+	bool hasUsd = false;
+	bool started = false;
+	std::vector<Column> cols;
+	std::vector<double> row;
+	std::optional<Iter> citer;
+
+	void open(Column &c, std::uint64_t f);
+	void advance(Column &c, std::uint64_t target);
+	bool fillRow(std::uint64_t t, double cp);
+	bool anyOpen() const;
+};
+
+template<typename Source>
+inline MatrixJoin<Source>::MatrixJoin(Source &pmap, const std::vector<std::string> &assets, std::string currency,
+		std::uint64_t from, std::uint64_t to, bool fillForward)
+	:pmap(pmap),currency(std::move(currency)),from(from),to(to?to:std::numeric_limits<std::uint64_t>::max())
+	,fillForward(fillForward),cols(assets.size()),row(assets.size()) {
+	for (std::size_t i = 0; i < assets.size(); i++) {
+		cols[i].symbol = assets[i];
+		if (assets[i] == "usd") hasUsd = true;
+	}
+}
+
+template<typename Source>
+inline void MatrixJoin<Source>::open(Column &c, std::uint64_t f) {
+	c.iter.reset();
+	c.iter.emplace(pmap.range({c.symbol, f},{c.symbol, to}));
+	c.ok = c.iter->next();
+	if (c.ok) c.t = itemTime(*c.iter);
+}
+
+template<typename Source>
+inline void MatrixJoin<Source>::advance(Column &c, std::uint64_t target) {
+	for (unsigned int i = 0; fillForward || i < mergeJoinSeekThreshold; i++) {
+		if (fillForward) c.last = itemPrice(*c.iter);
+		if (!(c.ok = c.iter->next())) return;
+		c.t = itemTime(*c.iter);
+		if (c.t >= target) return;
+	}
+	open(c, target);
+}
+
+//fills the row at time t, cp - price of the currency, returns false, when row is empty
+template<typename Source>
+inline bool MatrixJoin<Source>::fillRow(std::uint64_t t, double cp) {
+	constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+	bool any = false;
+	for (std::size_t i = 0; i < cols.size(); i++) {
+		Column &c = cols[i];
+		if (c.symbol == "usd") {
+			row[i] = 1.0/cp;
+			any = true;
+			continue;
+		}
+		if (c.ok && c.t < t) advance(c, t);
+		if (c.ok && c.t == t) {
+			c.last = itemPrice(*c.iter);
+			row[i] = c.last/cp;
+			any = true;
+		} else {
+			row[i] = fillForward?c.last/cp:nan;
+			any = any || (fillForward && !std::isnan(c.last));
+		}
+	}
+	return any;
+}
+
+template<typename Source>
+inline bool MatrixJoin<Source>::anyOpen() const {
+	for (const Column &c: cols) if (c.ok) return true;
+	return false;
+}
+
+template<typename Source>
+template<typename Fn>
+inline bool MatrixJoin<Source>::read(std::size_t count, Fn &&out) {
+	if (!started) {
+		started = true;
+		for (Column &c: cols) if (c.symbol != "usd") open(c, from);
+		if (currency != "usd") citer.emplace(pmap.range({currency, from},{currency, to}));
+	}
+	std::size_t rows = 0;
+	if (currency == "usd") {
+		while (anyOpen()) {
+			if (rows >= count) return true;
+			std::uint64_t t = std::numeric_limits<std::uint64_t>::max();
+			for (const Column &c: cols) if (c.ok) t = std::min(t, c.t);
+			fillRow(t, 1.0);
+			out(t, row.data());
+			rows++;
+			//step columns at t, so the next minimum is found
+			for (Column &c: cols) {
+				if (c.ok && c.t == t && (c.ok = c.iter->next())) c.t = itemTime(*c.iter);
+			}
+		}
+	} else {
+		while (rows < count) {
+			if (!citer->next()) return false;
+			if (!hasUsd && !anyOpen()) return false;
+			std::uint64_t t = itemTime(*citer);
+			if (fillRow(t, itemPrice(*citer))) out(t, row.data());
+			rows++;
+		}
+		return true;
+	}
+	return false;
+}
+
+///Joins prices of several assets quoted in one currency on a shared time axis
+/**
+ * See MatrixJoin
+ *
+ * @param pmap source of minute prices
+ * @param assets list of assets ("usd" can be included)
+ * @param currency currency
+ * @param from first time
+ * @param to end time, 0 - no limit
+ * @param fillForward missing prices are filled with last known price of the asset
+ * @param out function(std::uint64_t time, const double *values) - prices of the assets
+ *   in order of the list, NaN - missing price
+ */
+template<typename Source, typename Fn>
+void matrixJoin(Source &pmap, const std::vector<std::string> &assets, std::string_view currency,
+		std::uint64_t from, std::uint64_t to, bool fillForward, Fn &&out) {
+	MatrixJoin<Source> join(pmap, assets, std::string(currency), from, to, fillForward);
+	while (join.read(std::numeric_limits<std::size_t>::max(), out));
+}
+
+#endif /* SRC_MAIN_MATRIX_H_ */
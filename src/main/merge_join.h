@@ -0,0 +1,181 @@
+/*
+ * merge_join.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_MERGE_JOIN_H_
+#define SRC_MAIN_MERGE_JOIN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "candle.h"
+
+template<typename Iter>
+inline std::uint64_t itemTime(Iter &iter) {return iter.key(1).getUInt();}
+template<typename Iter>
+inline double itemPrice(Iter &iter) {return iter.value().getNumber();}
+template<typename Iter>
+inline void itemValue(Iter &iter, double &v) {v = itemPrice(iter);}
+///Reads the item as a candle, a single price is a candle with all prices equal
+template<typename Iter>
+inline void itemValue(Iter &iter, Candle &cd) {
+	double p = itemPrice(iter);
+	cd = {itemTime(iter), p, p, p, p};
+}
+///Count of minutes covered by the item
+template<typename Iter>
+inline std::uint64_t itemMinutes(Iter &) {return 1;}
+
+///Prepares the value to be repeated at following times (fill forward)
+inline void carryValue(double &) {}
+///Repeated candle is its close only
+inline void carryValue(Candle &cd) {cd.o = cd.h = cd.l = cd.c;}
+
+///Count of steps of lagging iterator before it is reopened at time of the leading iterator
+static constexpr unsigned int mergeJoinSeekThreshold = 16;
+
+///Joins two ascending time series, items are read in parts
+/**
+ * Same join as mergeJoin(), but the state of the join is kept in the object, so
+ * reading can be suspended and resumed later
+ *
+ * @tparam Open1 function(std::uint64_t from) - opens iterator of the first series at given time
+ * @tparam Open2 function(std::uint64_t from) - opens iterator of the second series at given time
+ * @tparam Value type of the value of an item (double - price, Candle - price or rolled up candle),
+ *  read by itemValue()
+ */
+template<typename Open1, typename Open2, typename Value = double>
+class MergeJoin {
+public:
+	///Construct join
+	/**
+	 * @param from starting time
+	 * @param open1 opens iterator of the first series (iterators are opened now)
+	 * @param open2 opens iterator of the second series
+	 * @param fillForward see mergeJoin()
+	 */
+	MergeJoin(std::uint64_t from, Open1 open1, Open2 open2, bool fillForward)
+		:open1(std::move(open1)),open2(std::move(open2))
+		,iter1(std::in_place, this->open1(from)),iter2(std::in_place, this->open2(from))
+		,fillForward(fillForward) {}
+
+	///Reads next part of the join
+	/**
+	 * @param count approximate count of emitted items, at least one item is emitted, unless
+	 *  the join is complete
+	 * @param out function(std::uint64_t time, const Value &v1, const Value &v2)
+	 * @retval true more items can follow
+	 * @retval false join is complete
+	 */
+	template<typename Fn>
+	bool read(std::size_t count, Fn &&out);
+
+protected:
+	Open1 open1;
+	Open2 open2;
+	std::optional<decltype(std::declval<Open1 &>()(0))> iter1;
+	std::optional<decltype(std::declval<Open2 &>()(0))> iter2;
+	bool fillForward;
+	bool started = false;
+	bool ok1 = false, ok2 = false;
+	std::uint64_t t1 = 0, t2 = 0;
+	//last values (fill forward)
+	bool has1 = false, has2 = false;
+	Value v1 = {}, v2 = {};
+};
+
+template<typename Open1, typename Open2, typename Value>
+template<typename Fn>
+inline bool MergeJoin<Open1, Open2, Value>::read(std::size_t count, Fn &&out) {
+	if (!started) {
+		started = true;
+		ok1 = iter1->next();
+		ok2 = iter2->next();
+		if (ok1) t1 = itemTime(*iter1);
+		if (ok2) t2 = itemTime(*iter2);
+	}
+	std::size_t emitted = 0;
+	if (fillForward) {
+		while (ok1 && ok2) {
+			if (emitted >= count) return true;
+			std::uint64_t t = std::min(t1, t2);
+			if (t1 == t) {
+				itemValue(*iter1, v1);
+				has1 = true;
+			}
+			if (t2 == t) {
+				itemValue(*iter2, v2);
+				has2 = true;
+			}
+			if (has1 && has2) {
+				out(t, v1, v2);
+				emitted++;
+			}
+			carryValue(v1);
+			carryValue(v2);
+			if (t1 == t && (ok1 = iter1->next())) t1 = itemTime(*iter1);
+			if (t2 == t && (ok2 = iter2->next())) t2 = itemTime(*iter2);
+		}
+	} else {
+		auto advance = [](auto &iter, auto &open, std::uint64_t &t, std::uint64_t target) {
+			for (unsigned int i = 0; i < mergeJoinSeekThreshold; i++) {
+				if (!iter->next()) return false;
+				t = itemTime(*iter);
+				if (t >= target) return true;
+			}
+			iter.reset();
+			iter.emplace(open(target));
+			if (!iter->next()) return false;
+			t = itemTime(*iter);
+			return true;
+		};
+		while (ok1 && ok2) {
+			if (emitted >= count) return true;
+			if (t1 == t2) {
+				auto &i1 = *iter1;
+				auto &i2 = *iter2;
+				Value a, b;
+				do {
+					itemValue(i1, a);
+					itemValue(i2, b);
+					out(t1, a, b);
+					emitted++;
+					if (!(ok1 = i1.next()) || !(ok2 = i2.next())) return false;
+					t1 = itemTime(i1);
+					t2 = itemTime(i2);
+				} while (t1 == t2 && emitted < count);
+			} else if (t1 < t2) {
+				ok1 = advance(iter1, open1, t1, t2);
+			} else {
+				ok2 = advance(iter2, open2, t2, t1);
+			}
+		}
+	}
+	return false;
+}
+
+///Joins two ascending time series
+/**
+ * @param from starting time
+ * @param open1 function(std::uint64_t from) - opens iterator of the first series at given time
+ * @param open2 function(std::uint64_t from) - opens iterator of the second series at given time
+ * @param fillForward when true, every time of both series is emitted with the last known
+ *  value of the other series (until one of the series ends). Otherwise, only times present
+ *  in both series are emitted and the lagging iterator is reopened at the time
+ *  of the leading iterator when it cannot catch up in few steps
+ * @param out function(std::uint64_t time, double v1, double v2)
+ */
+template<typename Open1, typename Open2, typename Fn>
+void mergeJoin(std::uint64_t from, Open1 &&open1, Open2 &&open2, bool fillForward, Fn &&out) {
+	MergeJoin<std::decay_t<Open1>, std::decay_t<Open2> > join(from, std::forward<Open1>(open1), std::forward<Open2>(open2), fillForward);
+	while (join.read(std::numeric_limits<std::size_t>::max(), out));
+}
+
+#endif /* SRC_MAIN_MERGE_JOIN_H_ */
@@ -0,0 +1,155 @@
+/*
+ * metrics.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+unsigned int metrics_detail::threadSlot() {
+	static std::atomic<unsigned int> next(0);
+	static thread_local unsigned int slot = next++ % shards;
+	return slot;
+}
+
+std::uint64_t Counter::get() const {
+	std::uint64_t r = 0;
+	for (const auto &s: slots) r += s.v.load(std::memory_order_relaxed);
+	return r;
+}
+
+unsigned int Histogram::bucketOf(std::uint64_t value) {
+	constexpr std::uint64_t sub = 1 << subBits;
+	if (value < sub) return static_cast<unsigned int>(value);
+	unsigned int e = 63 - __builtin_clzll(value);
+	if (e >= maxBits) return buckets - 1;
+	return ((e - subBits + 1) << subBits) + static_cast<unsigned int>((value >> (e - subBits)) & (sub - 1));
+}
+
+std::uint64_t Histogram::bucketBase(unsigned int idx) {
+	constexpr unsigned int sub = 1 << subBits;
+	if (idx < sub) return idx;
+	unsigned int e = (idx >> subBits) + subBits - 1;
+	return static_cast<std::uint64_t>(sub + (idx & (sub - 1))) << (e - subBits);
+}
+
+void Histogram::record(std::uint64_t value) {
+	Shard &s = data[metrics_detail::threadSlot()];
+	s.counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+	s.count.fetch_add(1, std::memory_order_relaxed);
+	s.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+	Snapshot out;
+	out.counts.resize(buckets, 0);
+	for (const auto &s: data) {
+		for (unsigned int i = 0; i < buckets; i++) out.counts[i] += s.counts[i].load(std::memory_order_relaxed);
+		out.count += s.count.load(std::memory_order_relaxed);
+		out.sum += s.sum.load(std::memory_order_relaxed);
+	}
+	return out;
+}
+
+double Histogram::Snapshot::quantile(double q) const {
+	std::uint64_t total = 0;
+	for (auto c: counts) total += c;
+	if (total == 0) return 0;
+	std::uint64_t rank = static_cast<std::uint64_t>(q * (total - 1)) + 1;
+	std::uint64_t acc = 0;
+	for (unsigned int i = 0; i < counts.size(); i++) {
+		acc += counts[i];
+		if (acc >= rank) {
+			//middle of the bucket
+			double lo = static_cast<double>(bucketBase(i));
+			double hi = i + 1 < counts.size()?static_cast<double>(bucketBase(i+1)):lo;
+			return (lo + hi) * 0.5;
+		}
+	}
+	return static_cast<double>(bucketBase(buckets-1));
+}
+
+Histogram &Metrics::histogram(const std::string &name, const std::string &labels, double scale) {
+	{
+		std::shared_lock _(lock);
+		auto iter = histograms.find(name);
+		if (iter != histograms.end()) {
+			auto iter2 = iter->second.find(labels);
+			if (iter2 != iter->second.end()) return *iter2->second.h;
+		}
+	}
+	std::unique_lock _(lock);
+	auto &item = histograms[name][labels];
+	if (!item.h) {
+		item.h = std::make_unique<Histogram>();
+		item.scale = scale;
+	}
+	return *item.h;
+}
+
+Counter &Metrics::counter(const std::string &name, const std::string &labels) {
+	{
+		std::shared_lock _(lock);
+		auto iter = counters.find(name);
+		if (iter != counters.end()) {
+			auto iter2 = iter->second.find(labels);
+			if (iter2 != iter->second.end()) return *iter2->second;
+		}
+	}
+	std::unique_lock _(lock);
+	auto &item = counters[name][labels];
+	if (!item) item = std::make_unique<Counter>();
+	return *item;
+}
+
+void Metrics::gauge(const std::string &name, const std::string &labels, std::function<double()> fn) {
+	std::unique_lock _(lock);
+	gauges[name][labels] = std::move(fn);
+}
+
+static std::string joinLabels(const std::string &labels, const char *extra) {
+	std::string out("{");
+	out.append(labels);
+	if (!labels.empty() && *extra) out.push_back(',');
+	out.append(extra);
+	out.push_back('}');
+	return out == "{}"?std::string():out;
+}
+
+std::string Metrics::exposition() const {
+	static constexpr std::pair<const char *, double> quantiles[] = {
+			{"quantile=\"0.5\"",0.5},{"quantile=\"0.9\"",0.9},{"quantile=\"0.99\"",0.99},{"quantile=\"0.999\"",0.999}
+	};
+	std::ostringstream out;
+	std::shared_lock _(lock);
+	for (const auto &h: histograms) {
+		out << "# TYPE " << h.first << " summary\n";
+		for (const auto &l: h.second) {
+			auto snap = l.second.h->snapshot();
+			double scale = l.second.scale;
+			for (const auto &q: quantiles) {
+				out << h.first << joinLabels(l.first, q.first) << ' ' << snap.quantile(q.second) * scale << '\n';
+			}
+			out << h.first << "_sum" << joinLabels(l.first, "") << ' ' << snap.sum * scale << '\n';
+			out << h.first << "_count" << joinLabels(l.first, "") << ' ' << snap.count << '\n';
+		}
+	}
+	for (const auto &c: counters) {
+		out << "# TYPE " << c.first << " counter\n";
+		for (const auto &l: c.second) {
+			out << c.first << joinLabels(l.first, "") << ' ' << l.second->get() << '\n';
+		}
+	}
+	for (const auto &g: gauges) {
+		out << "# TYPE " << g.first << " gauge\n";
+		for (const auto &l: g.second) {
+			out << g.first << joinLabels(l.first, "") << ' ' << l.second() << '\n';
+		}
+	}
+	return out.str();
+}
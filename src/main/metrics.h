@@ -0,0 +1,116 @@
+/*
+ * metrics.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_METRICS_H_
+#define SRC_MAIN_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metrics_detail {
+	///Index of the shard used by current thread
+	unsigned int threadSlot();
+	static constexpr unsigned int shards = 8;
+}
+
+///Counter, updated without locks
+/**
+ * Counter is split into shards, each thread updates own shard
+ */
+class Counter {
+public:
+	void add(std::uint64_t v = 1) {
+		slots[metrics_detail::threadSlot()].v.fetch_add(v, std::memory_order_relaxed);
+	}
+	std::uint64_t get() const;
+protected:
+	struct alignas(64) Slot {
+		std::atomic<std::uint64_t> v = 0;
+	};
+	std::array<Slot, metrics_detail::shards> slots;
+};
+
+///Log-linear histogram (HDR style), updated without locks
+/**
+ * Each power of two is split into 16 sub-buckets, so the relative error is below 7%.
+ * Values up to 2^40 are recorded, larger values are clamped.
+ */
+class Histogram {
+public:
+	static constexpr unsigned int subBits = 4;
+	static constexpr unsigned int maxBits = 40;
+	static constexpr unsigned int buckets = (maxBits - subBits + 1) << subBits;
+
+	void record(std::uint64_t value);
+
+	struct Snapshot {
+		std::vector<std::uint64_t> counts;
+		std::uint64_t count = 0;
+		std::uint64_t sum = 0;
+		///Returns approximate quantile
+		double quantile(double q) const;
+	};
+	Snapshot snapshot() const;
+
+	static unsigned int bucketOf(std::uint64_t value);
+	///Returns lowest value of the bucket
+	static std::uint64_t bucketBase(unsigned int idx);
+
+protected:
+	struct alignas(64) Shard {
+		std::array<std::atomic<std::uint64_t>, buckets> counts = {};
+		std::atomic<std::uint64_t> count = 0;
+		std::atomic<std::uint64_t> sum = 0;
+	};
+	std::array<Shard, metrics_detail::shards> data;
+};
+
+///Registry of metrics, generates Prometheus text format
+class Metrics {
+public:
+
+	///Returns histogram
+	/**
+	 * @param name name of the metric
+	 * @param labels labels in Prometheus format (route="/minute"), can be empty
+	 * @param scale multiplier of recorded values in the exposition (1e-6 - recorded in microseconds,
+	 * exposed in seconds)
+	 * @return reference, valid for lifetime of the registry
+	 */
+	Histogram &histogram(const std::string &name, const std::string &labels, double scale = 1e-6);
+	///Returns counter
+	Counter &counter(const std::string &name, const std::string &labels);
+	///Registers gauge
+	/**
+	 * @param fn function returns current value
+	 */
+	void gauge(const std::string &name, const std::string &labels, std::function<double()> fn);
+
+	///Generates exposition in Prometheus text format
+	std::string exposition() const;
+
+protected:
+	struct HistItem {
+		std::unique_ptr<Histogram> h;
+		double scale;
+	};
+
+	mutable std::shared_mutex lock;
+	std::map<std::string, std::map<std::string, HistItem> > histograms;
+	std::map<std::string, std::map<std::string, std::unique_ptr<Counter> > > counters;
+	std::map<std::string, std::map<std::string, std::function<double()> > > gauges;
+};
+
+#endif /* SRC_MAIN_METRICS_H_ */
@@ -0,0 +1,186 @@
+/*
+ * normalizer.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "normalizer.h"
+
+#include <cctype>
+#include <cmath>
+
+static void lowercase(std::string &s) {
+	for (char &c: s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+double RowFields::number(std::size_t idx) const {
+	if (!present[idx]) return 0;
+	return std::strtod(values[idx].c_str(), nullptr);
+}
+
+void RowFields::reset(std::size_t count) {
+	if (values.size() < count) values.resize(count);
+	present.assign(count, false);
+}
+
+void RowFields::set(std::size_t idx, std::string_view value) {
+	values[idx].assign(value.begin(), value.end());
+	present[idx] = true;
+}
+
+RuleAdapter::RuleAdapter(Rules rules):rules(std::move(rules)) {
+	flds.push_back(this->rules.symbol);
+	flds.push_back(this->rules.price);
+	if (!this->rules.quoteField.empty()) flds.push_back(this->rules.quoteField);
+}
+
+void RuleAdapter::normalize(const RowFields &row, Output &out) const {
+	std::string_view symbol = row.text(0);
+	if (!rules.prefix.empty()) {
+		if (symbol.substr(0, rules.prefix.length()) != rules.prefix) return;
+		symbol = symbol.substr(rules.prefix.length());
+	}
+	if (!rules.quoteField.empty() && row.text(2) != rules.quote) return;
+	if (!rules.suffixes.empty()) {
+		auto iter = std::find_if(rules.suffixes.begin(), rules.suffixes.end(), [&](const std::string &sfx){
+			return symbol.length() > sfx.length() && symbol.substr(symbol.length() - sfx.length()) == sfx;
+		});
+		if (iter == rules.suffixes.end()) return;
+		symbol = symbol.substr(0, symbol.length() - iter->length());
+	}
+	if (symbol.empty()) return;
+	if (rules.lowercase) {
+		buffer.assign(symbol.begin(), symbol.end());
+		lowercase(buffer);
+		symbol = buffer;
+	}
+	out.push(symbol, row.number(1));
+}
+
+namespace {
+
+///FTX markets - spot markets quoted in USD and futures (expiring futures are merged into symbol-fut)
+class FtxAdapter: public SourceAdapter {
+public:
+	virtual std::string_view rowsPath() const override {return "result";}
+	virtual const std::vector<std::string> &fields() const override {return flds;}
+	virtual void normalize(const RowFields &row, Output &out) const override {
+		if (row.text(0) == "future") {
+			std::string_view name = row.text(1);
+			std::string_view base = name;
+			while (!base.empty() && base.back()>='0' && base.back()<='9') base.remove_suffix(1);
+			if (!base.empty() && base.back()=='-') {
+				buffer.assign(base.begin(), base.end());
+				buffer.append("fut");
+			} else {
+				buffer.assign(name.begin(), name.end());
+			}
+		} else {
+			if (row.text(3) != "USD") return;
+			std::string_view base = row.text(2);
+			buffer.assign(base.begin(), base.end());
+		}
+		lowercase(buffer);
+		out.push(buffer, row.number(4));
+	}
+protected:
+	std::vector<std::string> flds = {"type","name","baseCurrency","quoteCurrency","price"};
+	mutable std::string buffer;
+};
+
+///Bitfinex tickers - array rows, trading pairs start with 't', pairs quoted in USD are used
+class BitfinexAdapter: public SourceAdapter {
+public:
+	virtual std::string_view rowsPath() const override {return "";}
+	virtual const std::vector<std::string> &fields() const override {return flds;}
+	virtual void normalize(const RowFields &row, Output &out) const override {
+		std::string_view symbol = row.text(0);
+		if (symbol.empty() || symbol[0] != 't') return;
+		symbol = symbol.substr(1);
+		std::string_view asset, currency;
+		auto sep = symbol.find(':');
+		if (sep == symbol.npos) {
+			asset = symbol.substr(0,3);
+			currency = symbol.substr(std::min<std::size_t>(3, symbol.length()));
+		} else {
+			asset = symbol.substr(0, sep);
+			currency = symbol.substr(sep+1);
+		}
+		if (currency != "USD") return;
+		buffer.assign(asset.begin(), asset.end());
+		lowercase(buffer);
+		out.push(buffer, row.number(1));
+	}
+protected:
+	std::vector<std::string> flds = {"0","7"};
+	mutable std::string buffer;
+};
+
+}
+
+NormalizerRegistry::NormalizerRegistry() {
+	RuleAdapter::Rules cryptowatch;
+	cryptowatch.rows = "result.rows";
+	cryptowatch.lowercase = false;
+	cryptowatch.fallback = true;
+	add("cryptowatch", std::make_shared<RuleAdapter>(cryptowatch));
+
+	RuleAdapter::Rules binance;
+	binance.suffixes = {"USDT","BUSD"};
+	binance.mergeQuotes = true;
+	add("binance", std::make_shared<RuleAdapter>(binance));
+
+	add("ftx", std::make_shared<FtxAdapter>());
+	add("bitfinex", std::make_shared<BitfinexAdapter>());
+}
+
+void NormalizerRegistry::add(std::string name, PAdapter adapter) {
+	adapters[std::move(name)] = std::move(adapter);
+}
+
+const SourceAdapter *NormalizerRegistry::find(std::string_view name) const {
+	auto iter = adapters.find(name);
+	if (iter == adapters.end()) return nullptr;
+	return iter->second.get();
+}
+
+bool NormalizerRegistry::matches(const std::vector<std::string> &path, std::string_view binding, bool prefix) {
+	std::size_t i = 0;
+	while (!binding.empty()) {
+		auto sep = binding.find('.');
+		auto seg = binding.substr(0, sep);
+		binding = sep == binding.npos?std::string_view():binding.substr(sep+1);
+		if (i == path.size()) return prefix;
+		if (path[i] != seg) return false;
+		i++;
+	}
+	return i == path.size();
+}
+
+void IngestSink::operator()(const SourceAdapter &adapter, const RowFields &row) {
+	cur = &adapter;
+	adapter.normalize(row, *this);
+}
+
+void IngestSink::push(std::string_view symbol, double price) {
+	if (!std::isfinite(price) || price == 0) return;
+	if (cur->mergeQuotes()) {
+		auto res = merged.emplace(pipeline.intern(symbol), std::pair{price,1});
+		if (!res.second) {
+			res.first->second.first += price;
+			res.first->second.second++;
+		}
+	} else if (cur->fallback() && !forcePrimary) {
+		pipeline.addFallback(symbol, price);
+	} else {
+		pipeline.add(symbol, price);
+	}
+}
+
+void IngestSink::finish() {
+	for (const auto &m: merged) {
+		pipeline.add(m.first, m.second.first/m.second.second);
+	}
+	merged.clear();
+}
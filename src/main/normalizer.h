@@ -0,0 +1,287 @@
+/*
+ * normalizer.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_NORMALIZER_H_
+#define SRC_MAIN_NORMALIZER_H_
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ingest.h"
+#include "json_reader.h"
+
+///Selected scalar fields of one row of exchange data
+class RowFields {
+public:
+	///Returns true, if the field is present
+	bool has(std::size_t idx) const {return present[idx];}
+	///Returns text of the field (strings are unescaped, numbers as written)
+	std::string_view text(std::size_t idx) const {return present[idx]?std::string_view(values[idx]):std::string_view();}
+	///Returns field as number (0, if not number)
+	double number(std::size_t idx) const;
+
+	void reset(std::size_t count);
+	void set(std::size_t idx, std::string_view value);
+
+protected:
+	std::vector<std::string> values;
+	std::vector<bool> present;
+};
+
+///Converts rows of an exchange to (symbol, price)
+/**
+ * Adapter declares where rows are located and which fields it needs. The registry
+ * parses the body as a stream and passes only these fields to normalize(), no document
+ * is built.
+ */
+class SourceAdapter {
+public:
+	///Receives normalized prices
+	class Output {
+	public:
+		virtual ~Output() = default;
+		virtual void push(std::string_view symbol, double price) = 0;
+	};
+
+	virtual ~SourceAdapter() = default;
+	///Path to the array of rows - keys and array indexes separated by dot, empty for root
+	virtual std::string_view rowsPath() const = 0;
+	///Fields needed by the normalizer - keys for object rows, indexes for array rows
+	virtual const std::vector<std::string> &fields() const = 0;
+	///Processes one row, fields are in order of fields()
+	virtual void normalize(const RowFields &row, Output &out) const = 0;
+	///Prices are used only when no other source has the symbol
+	virtual bool fallback() const {return false;}
+	///Multiple rows of the same symbol (different quote currencies) count as one price
+	virtual bool mergeQuotes() const {return false;}
+};
+
+///Adapter configured by rules
+/**
+ * Covers most exchanges: row has a symbol and a price, optionally a quote currency.
+ */
+class RuleAdapter: public SourceAdapter {
+public:
+	struct Rules {
+		///path to rows
+		std::string rows;
+		///field containing symbol
+		std::string symbol = "symbol";
+		///field containing price
+		std::string price = "price";
+		///field containing quote currency (optional)
+		std::string quoteField;
+		///required quote currency (when quoteField is set)
+		std::string quote;
+		///prefix removed from the symbol (row is skipped, when it is missing)
+		std::string prefix;
+		///accepted suffixes of the symbol (quote currencies), removed from the symbol.
+		///When not empty, other rows are skipped
+		std::vector<std::string> suffixes;
+		bool lowercase = true;
+		bool fallback = false;
+		bool mergeQuotes = false;
+	};
+
+	RuleAdapter(Rules rules);
+	virtual std::string_view rowsPath() const override {return rules.rows;}
+	virtual const std::vector<std::string> &fields() const override {return flds;}
+	virtual void normalize(const RowFields &row, Output &out) const override;
+	virtual bool fallback() const override {return rules.fallback;}
+	virtual bool mergeQuotes() const override {return rules.mergeQuotes;}
+
+protected:
+	Rules rules;
+	std::vector<std::string> flds;
+	mutable std::string buffer;
+};
+
+///Registry of exchange adapters
+class NormalizerRegistry {
+public:
+	using PAdapter = std::shared_ptr<const SourceAdapter>;
+
+	///Binds an adapter to the path of rows (used, when a body contains data of multiple sources)
+	struct Binding {
+		std::string path;
+		const SourceAdapter *adapter;
+	};
+
+	///Constructs registry with builtin adapters (cryptowatch, ftx, bitfinex, binance)
+	NormalizerRegistry();
+
+	///Registers adapter (replaces existing)
+	void add(std::string name, PAdapter adapter);
+	///Finds adapter
+	/**
+	 * @return adapter or nullptr
+	 */
+	const SourceAdapter *find(std::string_view name) const;
+
+	///Parses a body and passes rows to the adapters
+	/**
+	 * @param src function returns next character or -1 at the end
+	 * @param bindings adapters and paths of their rows
+	 * @param out function(const SourceAdapter &adapter, const RowFields &row)
+	 * @return count of processed rows
+	 */
+	template<typename Source, typename Fn>
+	static std::size_t parse(Source &&src, const std::vector<Binding> &bindings, Fn &&out);
+
+	///Parses a body of one source
+	template<typename Source, typename Fn>
+	static std::size_t parse(Source &&src, const SourceAdapter &adapter, Fn &&out) {
+		return parse(std::forward<Source>(src), {{std::string(adapter.rowsPath()), &adapter}}, std::forward<Fn>(out));
+	}
+
+protected:
+	std::map<std::string, PAdapter, std::less<> > adapters;
+
+	template<typename Reader, typename Fn>
+	static std::size_t readRows(Reader &rd, const SourceAdapter &adapter, RowFields &row, Fn &out);
+	static bool matches(const std::vector<std::string> &path, std::string_view binding, bool prefix);
+};
+
+///Normalizes rows and stores prices into ingestion pipeline
+class IngestSink: public SourceAdapter::Output {
+public:
+	///Constructs sink
+	/**
+	 * @param pipeline target pipeline
+	 * @param forcePrimary ignore fallback flag of adapters
+	 */
+	IngestSink(IngestPipeline &pipeline, bool forcePrimary = false)
+		:pipeline(pipeline),forcePrimary(forcePrimary) {}
+
+	///Processes row
+	void operator()(const SourceAdapter &adapter, const RowFields &row);
+	///Flushes merged prices, call after parse
+	void finish();
+
+	virtual void push(std::string_view symbol, double price) override;
+
+protected:
+	IngestPipeline &pipeline;
+	bool forcePrimary;
+	const SourceAdapter *cur = nullptr;
+	std::map<IngestPipeline::SymbolId, std::pair<double, unsigned int> > merged;
+};
+
+template<typename Reader, typename Fn>
+inline std::size_t NormalizerRegistry::readRows(Reader &rd, const SourceAdapter &adapter, RowFields &row, Fn &out) {
+	const auto &flds = adapter.fields();
+	std::vector<int> indexes;
+	for (const auto &f: flds) {
+		char *end;
+		long idx = std::strtol(f.c_str(), &end, 10);
+		indexes.push_back(!f.empty() && *end == 0?static_cast<int>(idx):-1);
+	}
+	auto readValue = [&](std::size_t fld) {
+		auto t = rd.next();
+		switch (t) {
+		case Reader::string:
+		case Reader::number: if (fld < flds.size()) row.set(fld, rd.getText());break;
+		case Reader::boolean: if (fld < flds.size()) row.set(fld, rd.getBool()?"true":"false");break;
+		case Reader::begin_object:
+		case Reader::begin_array: rd.skip();break;
+		default: break;
+		}
+		return t;
+	};
+	std::size_t count = 0;
+	for(;;) {
+		auto t = rd.next();
+		if (t == Reader::begin_object) {
+			row.reset(flds.size());
+			while ((t = rd.next()) == Reader::key) {
+				auto key = rd.getText();
+				std::size_t fld = 0;
+				while (fld < flds.size() && flds[fld] != key) fld++;
+				readValue(fld);
+			}
+			if (t != Reader::end_object) break;
+		} else if (t == Reader::begin_array) {
+			row.reset(flds.size());
+			for (int pos = 0;;pos++) {
+				std::size_t fld = 0;
+				while (fld < flds.size() && indexes[fld] != pos) fld++;
+				t = readValue(fld);
+				if (t == Reader::end_array || t == Reader::end || t == Reader::error) break;
+			}
+			if (t != Reader::end_array) break;
+		} else if (t == Reader::end_array || t == Reader::end || t == Reader::error) {
+			break;
+		} else {
+			continue;
+		}
+		out(adapter, row);
+		count++;
+	}
+	return count;
+}
+
+template<typename Source, typename Fn>
+inline std::size_t NormalizerRegistry::parse(Source &&src, const std::vector<Binding> &bindings, Fn &&out) {
+	JsonReader rd(std::forward<Source>(src));
+	using Reader = decltype(rd);
+	RowFields row;
+	std::size_t count = 0;
+	//path of the current container, stack of array indexes (-1 for objects)
+	std::vector<std::string> path;
+	std::vector<long> stk;
+	std::string lastKey;
+	for(;;) {
+		auto t = rd.next();
+		if (t == Reader::end || t == Reader::error) break;
+		if (t == Reader::key) {
+			lastKey = rd.getText();
+			continue;
+		}
+		if (t == Reader::end_object || t == Reader::end_array) {
+			if (stk.empty()) break;
+			stk.pop_back();
+			if (!path.empty() && path.size() >= stk.size()) path.pop_back();
+			continue;
+		}
+		bool root = stk.empty();
+		std::string seg;
+		if (!root) {
+			if (stk.back() >= 0) seg = std::to_string(stk.back()++);
+			else seg = lastKey;
+		}
+		if (t != Reader::begin_object && t != Reader::begin_array) continue;
+		if (!root) path.push_back(std::move(seg));
+		if (t == Reader::begin_array) {
+			auto iter = std::find_if(bindings.begin(), bindings.end(), [&](const Binding &b){
+				return matches(path, b.path, false);
+			});
+			if (iter != bindings.end()) {
+				count += readRows(rd, *iter->adapter, row, out);
+				if (!root) path.pop_back();
+				if (root) break;
+				continue;
+			}
+		}
+		if (std::none_of(bindings.begin(), bindings.end(), [&](const Binding &b){
+				return matches(path, b.path, true);
+			})) {
+			rd.skip();
+			if (!root) path.pop_back();
+			if (root) break;
+			continue;
+		}
+		stk.push_back(t == Reader::begin_array?0:-1);
+	}
+	return count;
+}
+
+#endif /* SRC_MAIN_NORMALIZER_H_ */
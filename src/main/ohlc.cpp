@@ -0,0 +1,128 @@
+/*
+ * ohlc.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "ohlc.h"
+
+#include <algorithm>
+#include <limits>
+#include "../shared/logOutput.h"
+
+using namespace docdb;
+
+///Maps key of source view to the frame of target view
+/**
+ * @param srcTf timeframe of the source (1 for the minute map, because its keys are in seconds)
+ * @param tf timeframe of the target view
+ */
+static auto frameMapper(std::uint64_t srcTf, std::uint64_t tf) {
+	return [=](json::Value key, IMapKey &mp) {
+		json::Value symb = key[0];
+		std::uint64_t ratio = tf/srcTf;
+		std::uint64_t frame = key[1].getUInt()/ratio;
+		mp.range({symb, frame}, {symb, frame*ratio}, {symb, (frame+1)*ratio}, false, {symb, frame*ratio, (frame+1)*ratio});
+	};
+}
+
+///Folds prices or candles into one candle
+template<typename Iter>
+static json::Value foldCandles(Iter &iter) {
+	if (!iter.next()) return json::Value();
+	double o,h,l,c;
+	json::Value v = iter.value();
+	if (v.type() == json::array) {
+		o = v[0].getNumber();
+		h = v[1].getNumber();
+		l = v[2].getNumber();
+		c = v[3].getNumber();
+	} else {
+		o = h = l = c = v.getNumber();
+	}
+	while (iter.next()) {
+		v = iter.value();
+		if (v.type() == json::array) {
+			h = std::max(h, v[1].getNumber());
+			l = std::min(l, v[2].getNumber());
+			c = v[3].getNumber();
+		} else {
+			double p = v.getNumber();
+			h = std::max(h, p);
+			l = std::min(l, p);
+			c = p;
+		}
+	}
+	return {o,h,l,c};
+}
+
+static json::Value foldView(JsonMap::Iterator &iter, const json::Value &) {
+	return foldCandles(iter);
+}
+
+OHLCViews::OHLCViews(PriceStore &store)
+	:v5m(store.minutes(), "ohlc_5m", frameMapper(1, 300), [&store](JsonMap::Iterator &iter, const json::Value &range) -> json::Value {
+			if (store.indirect()) {
+				auto siter = store.range({range[0], range[1]},{range[0], range[2]});
+				return foldCandles(siter);
+			}
+			return foldCandles(iter);
+	})
+	,v15m(v5m, "ohlc_15m", frameMapper(300, 900), foldView)
+	,v1h(v15m, "ohlc_1h", frameMapper(900, 3600), foldView)
+	,v4h(v1h, "ohlc_4h", frameMapper(3600, 14400), foldView)
+	,v1d(v1h, "ohlc_1d", frameMapper(3600, 86400), foldView)
+{
+
+}
+
+std::uint64_t OHLCViews::bestTimeframe(std::uint64_t tfrm) {
+	for (std::uint64_t tf: {86400, 14400, 3600, 900, 300}) {
+		if (tfrm % tf == 0) return tf;
+	}
+	return 0;
+}
+
+bool OHLCViews::empty() {
+	return !v5m.scan().next();
+}
+
+template<typename View>
+void OHLCViews::eraseView(View &view, Batch &batch, std::string_view symbol) {
+	for (auto iter = view.range({symbol, 0},{symbol, std::numeric_limits<std::uint64_t>::max()}); iter.next();) {
+		view.erase(batch, iter.key());
+	}
+}
+
+void OHLCViews::erase(Batch &batch, std::string_view symbol) {
+	eraseView(v5m, batch, symbol);
+	eraseView(v15m, batch, symbol);
+	eraseView(v1h, batch, symbol);
+	eraseView(v4h, batch, symbol);
+	eraseView(v1d, batch, symbol);
+}
+
+void OHLCViews::populate(DB &db, JsonMap &pmap) {
+	ondra_shared::logNote("Building OHLC views from minute data");
+	//writing any minute of the frame marks whole frame dirty, so touch first minute of each 5m frame
+	Batch batch;
+	json::Value symbol;
+	std::uint64_t lastFrame = 0;
+	std::size_t cnt = 0;
+	for (auto iter = pmap.scan(); iter.next();) {
+		json::Value key = iter.key();
+		std::uint64_t frame = key[1].getUInt()/300;
+		if (key[0] != symbol || frame != lastFrame) {
+			symbol = key[0];
+			lastFrame = frame;
+			pmap.set(batch, key, iter.value());
+			if (++cnt % 10000 == 0) {
+				db.commitBatch(batch);
+				batch.Clear();
+			}
+		}
+	}
+	db.commitBatch(batch);
+	ondra_shared::logNote("OHLC views built: $1 frames", cnt);
+}
@@ -0,0 +1,104 @@
+/*
+ * ohlc.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_OHLC_H_
+#define SRC_MAIN_OHLC_H_
+
+#include <cstdint>
+#include <string_view>
+
+#include "../docdb/src/docdblib/aggregator_view.h"
+#include "../docdb/src/docdblib/db.h"
+#include "../docdb/src/docdblib/json_map.h"
+#include "price_store.h"
+
+///Precomputed candles for common timeframes
+/**
+ * Every view stores [o,h,l,c] under the key [symbol, frame], where frame = time/timeframe.
+ * The 5m view is aggregated from the minute map, every coarser view is aggregated
+ * from a finer view, so a single new minute updates only one key on each level.
+ * In the columnar mode, the 5m candles are folded from the price store, because
+ * minutes of sealed days are no longer in the minute map
+ */
+class OHLCViews {
+public:
+
+	using View5m = docdb::AggregatorView<docdb::JsonMap::AggregatorAdapter>;
+	using View15m = docdb::AggregatorView<View5m::AggregatorAdapter>;
+	using View1h = docdb::AggregatorView<View15m::AggregatorAdapter>;
+	using View4h = docdb::AggregatorView<View1h::AggregatorAdapter>;
+	using View1d = docdb::AggregatorView<View1h::AggregatorAdapter>;
+
+	OHLCViews(PriceStore &store);
+
+	///Returns coarsest stored timeframe which divides given timeframe
+	/**
+	 * @param tfrm timeframe in seconds
+	 * @return stored timeframe in seconds, or 0 if there is no such timeframe
+	 */
+	static std::uint64_t bestTimeframe(std::uint64_t tfrm);
+
+	///Enumerates stored candles
+	/**
+	 * @param tf stored timeframe (must be one returned by bestTimeframe)
+	 * @param symbol symbol
+	 * @param fromFrame first frame (time/tf)
+	 * @param toFrame frame after last frame
+	 * @param fn function (std::uint64_t time, double o, double h, double l, double c)
+	 */
+	template<typename Fn>
+	void range(std::uint64_t tf, std::string_view symbol, std::uint64_t fromFrame, std::uint64_t toFrame, Fn &&fn);
+
+	///Fills the views from existing minute data (when the views were just created)
+	void populate(docdb::DB &db, docdb::JsonMap &pmap);
+
+	///Returns true, when views contain no data
+	bool empty();
+
+	///Erases all candles of the symbol
+	/**
+	 * Candles of sealed or rolled up days are not updated through the minute map,
+	 * so they must be erased explicitly
+	 */
+	void erase(docdb::Batch &batch, std::string_view symbol);
+
+	View5m v5m;
+	View15m v15m;
+	View1h v1h;
+	View4h v4h;
+	View1d v1d;
+
+protected:
+	template<typename View>
+	static void eraseView(View &view, docdb::Batch &batch, std::string_view symbol);
+	template<typename View, typename Fn>
+	static void enumView(View &view, std::uint64_t tf, std::string_view symbol, std::uint64_t fromFrame, std::uint64_t toFrame, Fn &fn);
+};
+
+template<typename View, typename Fn>
+inline void OHLCViews::enumView(View &view, std::uint64_t tf, std::string_view symbol, std::uint64_t fromFrame, std::uint64_t toFrame, Fn &fn) {
+	auto iter = view.range({symbol, fromFrame},{symbol, toFrame});
+	while (iter.next()) {
+		json::Value v = iter.value();
+		fn(iter.key(1).getUInt()*tf, v[0].getNumber(), v[1].getNumber(), v[2].getNumber(), v[3].getNumber());
+	}
+}
+
+template<typename Fn>
+inline void OHLCViews::range(std::uint64_t tf, std::string_view symbol, std::uint64_t fromFrame, std::uint64_t toFrame, Fn &&fn) {
+	switch (tf) {
+	case 300: enumView(v5m, tf, symbol, fromFrame, toFrame, fn);break;
+	case 900: enumView(v15m, tf, symbol, fromFrame, toFrame, fn);break;
+	case 3600: enumView(v1h, tf, symbol, fromFrame, toFrame, fn);break;
+	case 14400: enumView(v4h, tf, symbol, fromFrame, toFrame, fn);break;
+	case 86400: enumView(v1d, tf, symbol, fromFrame, toFrame, fn);break;
+	default: break;
+	}
+}
+
+
+#endif /* SRC_MAIN_OHLC_H_ */
@@ -0,0 +1,267 @@
+/*
+ * output_format.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_OUTPUT_FORMAT_H_
+#define SRC_MAIN_OUTPUT_FORMAT_H_
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class OutputFormat {
+	///[[time, price],...] - original format, formatted by %g
+	json,
+	///time,price lines, shortest roundtrip formatting
+	csv,
+	///binary columnar format
+	binary,
+	///binary columnar format, times are delta encoded
+	binary_delta
+};
+
+///Selects output format
+/**
+ * @param format value of format= query parameter (json, csv, bin, bin-delta), has priority
+ * @param accept value of Accept header
+ * @return selected format, json is default. Returns no value for unknown format= value
+ */
+inline std::optional<OutputFormat> selectOutputFormat(std::string_view format, std::string_view accept) {
+	if (format == "json") return OutputFormat::json;
+	if (format == "csv") return OutputFormat::csv;
+	if (format == "bin") return OutputFormat::binary;
+	if (format == "bin-delta") return OutputFormat::binary_delta;
+	if (!format.empty()) return std::nullopt;
+	if (accept.find("text/csv") != accept.npos) return OutputFormat::csv;
+	if (accept.find("application/octet-stream") != accept.npos) return OutputFormat::binary;
+	return OutputFormat::json;
+}
+
+inline std::string_view outputContentType(OutputFormat fmt) {
+	switch (fmt) {
+	case OutputFormat::csv: return "text/csv";
+	case OutputFormat::binary:
+	case OutputFormat::binary_delta: return "application/octet-stream";
+	default: return "application/json";
+	}
+}
+
+///Writes series of [time, values...] in selected format
+/**
+ * Binary format (all numbers little endian):
+ *
+ * header: "MMPB", u8 version (1), u8 flags (bit 0 - delta encoded times), u8 columns, u8 reserved
+ *
+ * followed by chunks: u32 count, times, columns * count * f64 values
+ *
+ * times are count * u64, or count * LEB128 varint of difference to previous time (delta encoding,
+ * first difference is relative to 0). The stream is terminated by chunk with count 0.
+ *
+ * Missing values (NaN) are written as null in the json format and as empty fields in the csv format
+ *
+ * @tparam Stream output stream (needs write(std::string_view))
+ */
+template<typename Stream>
+class SeriesWriter {
+public:
+
+	///Construct writer
+	/**
+	 * @param s output stream
+	 * @param fmt output format
+	 * @param columns count of values per row (1 - price, 4 - ohlc, up to 255)
+	 * @param separator separator of rows in the json format
+	 * @param header header line of the csv format (without newline), empty for default
+	 */
+	SeriesWriter(Stream &s, OutputFormat fmt, unsigned int columns, std::string_view separator, std::string_view header = std::string_view())
+		:s(s),fmt(fmt),columns(columns),separator(separator),header(header),values(columns) {}
+
+	void begin();
+	void push(std::uint64_t time, const double *values);
+	void end();
+
+	static constexpr std::size_t chunkSize = 4096;
+
+protected:
+	Stream &s;
+	OutputFormat fmt;
+	unsigned int columns;
+	std::string_view separator;
+	std::string_view header;
+	bool comma = false;
+
+	std::string buffer;
+	std::size_t count = 0;
+	std::uint64_t prevTime = 0;
+	std::string times;
+	std::vector<std::string> values;
+
+	void flushChunk();
+	static void putRaw(std::string &out, std::uint64_t v, unsigned int bytes);
+	static void putVarint(std::string &out, std::uint64_t v);
+};
+
+template<typename Stream>
+inline void SeriesWriter<Stream>::putRaw(std::string &out, std::uint64_t v, unsigned int bytes) {
+	for (unsigned int i = 0; i < bytes; i++) {
+		out.push_back(static_cast<char>(v & 0xFF));
+		v >>= 8;
+	}
+}
+
+template<typename Stream>
+inline void SeriesWriter<Stream>::putVarint(std::string &out, std::uint64_t v) {
+	while (v >= 0x80) {
+		out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<char>(v));
+}
+
+template<typename Stream>
+inline void SeriesWriter<Stream>::begin() {
+	switch (fmt) {
+	case OutputFormat::json:
+		s.write("[");
+		break;
+	case OutputFormat::csv:
+		if (header.empty()) {
+			s.write(columns == 4?"time,open,high,low,close\n":"time,price\n");
+		} else {
+			buffer.assign(header);
+			buffer.push_back('\n');
+			s.write(buffer);
+			buffer.clear();
+		}
+		break;
+	default:
+		buffer.assign("MMPB");
+		buffer.push_back(1);
+		buffer.push_back(fmt == OutputFormat::binary_delta?1:0);
+		buffer.push_back(static_cast<char>(columns));
+		buffer.push_back(0);
+		s.write(buffer);
+		buffer.clear();
+		break;
+	}
+}
+
+template<typename Stream>
+inline void SeriesWriter<Stream>::push(std::uint64_t time, const double *vals) {
+	switch (fmt) {
+	case OutputFormat::json: {
+			if (comma) {
+				s.write(separator);
+			} else {
+				comma = true;
+			}
+			char buff[200];
+			bool missing = false;
+			for (unsigned int i = 0; i < columns; i++) missing = missing || std::isnan(vals[i]);
+			if (!missing && columns == 4) {
+				snprintf(buff,sizeof(buff),"[%lu, %g, %g, %g, %g]", time, vals[0], vals[1], vals[2], vals[3]);
+				s.write(buff);
+				break;
+			}
+			if (!missing && columns == 1) {
+				snprintf(buff,sizeof(buff),"[%lu, %g]", time, vals[0]);
+				s.write(buff);
+				break;
+			}
+			//other widths and rows with missing values
+			buffer.clear();
+			snprintf(buff,sizeof(buff),"[%lu", time);
+			buffer.append(buff);
+			for (unsigned int i = 0; i < columns; i++) {
+				if (std::isnan(vals[i])) {
+					buffer.append(", null");
+				} else {
+					snprintf(buff,sizeof(buff),", %g", vals[i]);
+					buffer.append(buff);
+				}
+			}
+			buffer.push_back(']');
+			s.write(buffer);
+		}
+		break;
+	case OutputFormat::csv: {
+			char buff[32];
+			char *end = buff+sizeof(buff);
+			char *c = std::to_chars(buff, end, time).ptr;
+			buffer.append(buff, c - buff);
+			for (unsigned int i = 0; i < columns; i++) {
+				buffer.push_back(',');
+				if (!std::isnan(vals[i])) {
+					c = std::to_chars(buff, end, vals[i]).ptr;
+					buffer.append(buff, c - buff);
+				}
+			}
+			buffer.push_back('\n');
+			if (buffer.size() > 16384) {
+				s.write(buffer);
+				buffer.clear();
+			}
+		}
+		break;
+	default:
+		if (fmt == OutputFormat::binary_delta) {
+			putVarint(times, time - prevTime);
+			prevTime = time;
+		} else {
+			putRaw(times, time, 8);
+		}
+		for (unsigned int i = 0; i < columns; i++) {
+			std::uint64_t bits;
+			std::memcpy(&bits, vals+i, sizeof(bits));
+			putRaw(values[i], bits, 8);
+		}
+		if (++count >= chunkSize) flushChunk();
+		break;
+	}
+}
+
+template<typename Stream>
+inline void SeriesWriter<Stream>::flushChunk() {
+	if (count == 0) return;
+	buffer.clear();
+	putRaw(buffer, count, 4);
+	buffer.append(times);
+	for (unsigned int i = 0; i < columns; i++) {
+		buffer.append(values[i]);
+		values[i].clear();
+	}
+	s.write(buffer);
+	buffer.clear();
+	times.clear();
+	count = 0;
+}
+
+template<typename Stream>
+inline void SeriesWriter<Stream>::end() {
+	switch (fmt) {
+	case OutputFormat::json:
+		s.write("]");
+		break;
+	case OutputFormat::csv:
+		s.write(buffer);
+		buffer.clear();
+		break;
+	default:
+		flushChunk();
+		buffer.clear();
+		putRaw(buffer, 0, 4);
+		s.write(buffer);
+		break;
+	}
+}
+
+#endif /* SRC_MAIN_OUTPUT_FORMAT_H_ */
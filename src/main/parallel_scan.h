@@ -0,0 +1,179 @@
+/*
+ * parallel_scan.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_PARALLEL_SCAN_H_
+#define SRC_MAIN_PARALLEL_SCAN_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+///Produces shards of a long scan concurrently and consumes them in order
+/**
+ * Shards are produced by helper tasks dispatched to a thread pool and by the calling
+ * thread itself, so the scan progresses even when the pool is busy (or when all
+ * pool threads are waiting for own scans). Results are consumed on the calling
+ * thread in order of the shards.
+ *
+ * Count of threads working for one scan is limited by `parallel`. At most 2*parallel
+ * shards are being produced or waiting for consumption, which also limits memory
+ * used by one scan when the consumer is slow.
+ */
+class ParallelScan {
+public:
+	///Dispatches a task to the thread pool, returns false, when the task cannot be dispatched
+	using Dispatch = std::function<bool(std::function<void()> &&)>;
+
+	///Construct sequential scanner
+	ParallelScan() = default;
+	///Construct scanner
+	/**
+	 * @param dispatch function which dispatches tasks
+	 * @param parallel max count of threads used by one scan (including the calling thread)
+	 * @param shardSize size of a shard in seconds
+	 */
+	ParallelScan(Dispatch dispatch, unsigned int parallel, std::uint64_t shardSize)
+		:dispatch(std::move(dispatch)),parallel(std::max(parallel, 1U)),shardSize(std::max<std::uint64_t>(shardSize, 1)) {}
+
+	unsigned int getParallel() const {return dispatch?parallel:1;}
+	std::uint64_t getShardSize() const {return shardSize;}
+
+	///Runs the scan
+	/**
+	 * @tparam T type of item produced by a shard
+	 * @param count count of shards
+	 * @param produce function(std::size_t shard, std::vector<T> &items) - produces items of the shard
+	 *   (called on any thread)
+	 * @param consume function(std::vector<T> &items) - consumes items of the shard (called on the
+	 *   calling thread in order of the shards)
+	 *
+	 * Exception thrown by produce or consume stops the scan and it is rethrown, when
+	 * all running shards are finished
+	 */
+	template<typename T, typename Produce, typename Consume>
+	void run(std::size_t count, Produce &&produce, Consume &&consume) const;
+
+protected:
+	Dispatch dispatch;
+	unsigned int parallel = 1;
+	std::uint64_t shardSize = 30*24*60*60;
+};
+
+template<typename T, typename Produce, typename Consume>
+inline void ParallelScan::run(std::size_t count, Produce &&produce, Consume &&consume) const {
+	if (getParallel() < 2 || count < 2) {
+		std::vector<T> items;
+		for (std::size_t i = 0; i < count; i++) {
+			items.clear();
+			produce(i, items);
+			consume(items);
+		}
+		return;
+	}
+
+	struct State {
+		std::mutex lock;
+		std::condition_variable cond;
+		std::function<void(std::size_t, std::vector<T> &)> produce;
+		std::vector<std::optional<std::vector<T> > > results;
+		std::size_t window = 0;
+		std::size_t next = 0;
+		std::size_t consumed = 0;
+		std::size_t running = 0;
+		unsigned int helpers = 0;
+		bool stop = false;
+		std::exception_ptr error;
+
+		bool canClaim() const {
+			return !stop && next < results.size() && next < consumed + window;
+		}
+		//called under lock, lock is released while the shard is produced
+		void work(std::unique_lock<std::mutex> &lk) {
+			std::size_t i = next++;
+			running++;
+			lk.unlock();
+			std::vector<T> items;
+			std::exception_ptr e;
+			try {
+				produce(i, items);
+			} catch (...) {
+				e = std::current_exception();
+			}
+			lk.lock();
+			if (e) {
+				if (!error) error = e;
+				stop = true;
+			}
+			results[i] = std::move(items);
+			running--;
+			cond.notify_all();
+		}
+	};
+
+	auto st = std::make_shared<State>();
+	//produce is called only for claimed shards and the caller waits for all of them
+	st->produce = std::ref(produce);
+	st->results.resize(count);
+	st->window = 2*parallel;
+
+	auto helper = [st]{
+		std::unique_lock lk(st->lock);
+		while (st->canClaim()) st->work(lk);
+		st->helpers--;
+		st->cond.notify_all();
+	};
+	auto spawn = [&](std::unique_lock<std::mutex> &lk) {
+		while (st->helpers + 1 < parallel && st->canClaim() && st->next + 1 < count) {
+			st->helpers++;
+			lk.unlock();
+			bool ok = dispatch(helper);
+			lk.lock();
+			if (!ok) {
+				st->helpers--;
+				break;
+			}
+		}
+	};
+	auto finish = [&](std::unique_lock<std::mutex> &lk) {
+		st->stop = true;
+		st->cond.wait(lk, [&]{return st->running == 0;});
+	};
+
+	std::unique_lock lk(st->lock);
+	try {
+		while (st->consumed < count && !st->error) {
+			spawn(lk);
+			auto &r = st->results[st->consumed];
+			if (r.has_value()) {
+				std::vector<T> items(std::move(*r));
+				r.reset();
+				st->consumed++;
+				lk.unlock();
+				consume(items);
+				lk.lock();
+			} else if (st->canClaim()) {
+				st->work(lk);
+			} else {
+				st->cond.wait(lk);
+			}
+		}
+	} catch (...) {
+		if (!lk.owns_lock()) lk.lock();
+		finish(lk);
+		throw;
+	}
+	finish(lk);
+	if (st->error) std::rethrow_exception(st->error);
+}
+
+#endif /* SRC_MAIN_PARALLEL_SCAN_H_ */
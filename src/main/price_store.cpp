@@ -0,0 +1,269 @@
+/*
+ * price_store.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "price_store.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <imtjson/binary.h>
+#include "../shared/logOutput.h"
+
+using namespace docdb;
+
+PriceStore::PriceStore(DB &db, JsonMap &pmap, Mode mode)
+	:db(db),pmap(pmap),blocks(db,"pblk"),rollup(db,"rollup"),mode(mode) {}
+
+void PriceStore::setRollup(std::vector<std::uint64_t> timeframes) {
+	this->timeframes = std::move(timeframes);
+}
+
+GorillaDecoder PriceStore::decodeBlock(const json::Value &block) {
+	json::Binary bin = block.getBinary();
+	return GorillaDecoder(std::string_view(reinterpret_cast<const char *>(bin.data), bin.length));
+}
+
+PriceStore::Iterator::Iterator(const PriceStore &owner, const json::Value &symbol, std::uint64_t from, std::uint64_t to, bool withRollup)
+	:symbol(symbol),from(from),to(to)
+	,miter(owner.pmap.range({symbol, from},{symbol, to}))
+	,biter(owner.blocks.range({symbol, from/daysec},{symbol, to/daysec+1}))
+{
+	if (withRollup && !owner.timeframes.empty()) {
+		rollup = &owner.rollup;
+		timeframes = &owner.timeframes;
+		tier = timeframes->size();
+	}
+}
+
+bool PriceStore::Iterator::nextRollup() {
+	//from the coarsest tier, finer tiers continue where the coarser ends
+	while (rollup) {
+		if (riter && riter->next()) {
+			std::uint64_t t = riter->key(2).getUInt()*rollTf;
+			if (t < rollEnd) continue;
+			rollEnd = t + rollTf;
+			//the close is known at the last minute of the frame, not at its start
+			std::uint64_t tm = rollEnd - 60;
+			if (tm < from || tm >= to) continue;
+			candle = riter->value();
+			curTime = tm;
+			curPrice = candle[3].getNumber();
+			return true;
+		}
+		if (tier == 0) {
+			rollup = nullptr;
+			break;
+		}
+		rollTf = (*timeframes)[--tier];
+		auto ceilFrame = [&](std::uint64_t t) {return t/rollTf + (t%rollTf?1:0);};
+		riter.emplace(rollup->range({symbol, rollTf, from/rollTf},{symbol, rollTf, ceilFrame(to)}));
+	}
+	riter.reset();
+	candle = json::Value();
+	return false;
+}
+
+bool PriceStore::Iterator::nextBlockItem() {
+	for (;;) {
+		while (decoder.next()) {
+			if (decoder.time >= to) return false;
+			if (decoder.time >= from) {
+				tB = decoder.time;
+				vB = decoder.price;
+				return true;
+			}
+		}
+		if (!biter.next()) return false;
+		block = biter.value();
+		decoder = decodeBlock(block);
+	}
+}
+
+bool PriceStore::Iterator::next() {
+	if (rollup && nextRollup()) return true;
+	while (nextMinute()) {
+		if (curTime >= rollEnd) return true;
+	}
+	return false;
+}
+
+bool PriceStore::Iterator::nextMinute() {
+	if (needM) {
+		hasM = miter.next();
+		if (hasM) {
+			tM = miter.key(1).getUInt();
+			vM = miter.value().getNumber();
+		}
+		needM = false;
+	}
+	if (needB) {
+		hasB = nextBlockItem();
+		needB = false;
+	}
+	if (hasM && (!hasB || tM <= tB)) {
+		curTime = tM;
+		curPrice = vM;
+		needM = true;
+		needB = hasB && tB == tM;
+		return true;
+	} else if (hasB) {
+		curTime = tB;
+		curPrice = vB;
+		needB = true;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+PriceStore::Iterator PriceStore::range(const json::Value &from, const json::Value &to) const {
+	return Iterator(*this, from[0], from[1].getUInt(), to[1].getUInt());
+}
+
+PriceStore::Iterator PriceStore::minuteRange(const json::Value &from, const json::Value &to) const {
+	return Iterator(*this, from[0], from[1].getUInt(), to[1].getUInt(), false);
+}
+
+json::Value PriceStore::lookup(const json::Value &key) const {
+	json::Value v = pmap.lookup(key);
+	if (v.defined()) return v;
+	std::uint64_t tm = key[1].getUInt();
+	json::Value block = blocks.lookup({key[0], tm/daysec});
+	if (!block.defined()) return block;
+	GorillaDecoder dec = decodeBlock(block);
+	while (dec.next()) {
+		if (dec.time == tm) return dec.price;
+		if (dec.time > tm) break;
+	}
+	return json::Value();
+}
+
+bool PriceStore::asOf(const json::Value &symbol, std::uint64_t time, std::uint64_t tolerance, std::uint64_t &foundTime, double &price) const {
+	std::uint64_t lowest = time > tolerance?time - tolerance:0;
+	bool found = false;
+	//range from the higher key goes backward
+	auto miter = pmap.range({symbol, time},{symbol, lowest}, true);
+	if (miter.next()) {
+		foundTime = miter.key(1).getUInt();
+		price = miter.value().getNumber();
+		found = true;
+	}
+	if (mode != Mode::columnar) return found;
+	auto biter = blocks.range({symbol, time/daysec},{symbol, lowest/daysec}, true);
+	while (biter.next()) {
+		std::uint64_t day = biter.key(1).getUInt();
+		//minute map wins
+		if (found && (day+1)*daysec <= foundTime) break;
+		GorillaDecoder dec = decodeBlock(biter.value());
+		bool hit = false;
+		while (dec.next() && dec.time <= time) {
+			if (dec.time < lowest || (found && dec.time <= foundTime)) continue;
+			foundTime = dec.time;
+			price = dec.price;
+			hit = true;
+		}
+		if (hit) return true;
+	}
+	return found;
+}
+
+std::uint64_t PriceStore::rollupEnd(const json::Value &symbol) const {
+	std::uint64_t end = 0;
+	for (std::uint64_t tf: timeframes) {
+		//range from the higher key goes backward
+		auto iter = rollup.range({symbol, tf, std::numeric_limits<std::uint64_t>::max()},{symbol, tf, 0}, true);
+		if (iter.next()) end = std::max(end, (iter.key(2).getUInt()+1)*tf);
+	}
+	return end;
+}
+
+bool PriceStore::sealDue(std::uint64_t day) {
+	if (mode != Mode::columnar) return false;
+	std::uint64_t prev = sealedDay;
+	return day > prev && sealedDay.compare_exchange_strong(prev, day);
+}
+
+std::size_t PriceStore::seal(GroupCommit &writer, const json::Value &symbol, std::uint64_t day,
+		const std::function<bool(std::size_t)> &progress) {
+	if (mode != Mode::columnar) return 0;
+
+	Batch batch;
+	GorillaEncoder enc;
+	std::vector<std::pair<std::uint64_t, double> > minutes, merged, sealed;
+	std::uint64_t curDay = 0;
+	std::size_t blockCount = 0;
+	std::size_t minuteCount = 0;
+
+	auto commit = [&] {
+		//a minute written after it has been read stays in the minute map
+		writer.commit(batch, [&](Batch &b) {
+			for (const auto &x: sealed) {
+				json::Value v = pmap.lookup({symbol, x.first});
+				if (v.defined() && v.getNumber() == x.second) pmap.erase(b, {symbol, x.first});
+			}
+		});
+		batch.Clear();
+		sealed.clear();
+	};
+
+	auto flush = [&] {
+		if (minutes.empty()) return true;
+		sealed.insert(sealed.end(), minutes.begin(), minutes.end());
+		minuteCount += minutes.size();
+		std::size_t cnt = minutes.size();
+		merged.clear();
+		json::Value prev = blocks.lookup({symbol, curDay});
+		if (prev.defined()) {
+			GorillaDecoder dec = decodeBlock(prev);
+			auto iter = minutes.begin();
+			while (dec.next()) {
+				while (iter != minutes.end() && iter->first < dec.time) merged.push_back(*iter++);
+				//minute map wins
+				if (iter != minutes.end() && iter->first == dec.time) continue;
+				merged.push_back({dec.time, dec.price});
+			}
+			merged.insert(merged.end(), iter, minutes.end());
+		} else {
+			std::swap(merged, minutes);
+		}
+		minutes.clear();
+		for (const auto &x: merged) enc.add(x.first, x.second);
+		std::string data = enc.finish();
+		blocks.set(batch, {symbol, curDay}, json::Value(json::BinaryView(reinterpret_cast<const unsigned char *>(data.data()), data.size())));
+		if (++blockCount % 10 == 0) commit();
+		return !progress || progress(cnt);
+	};
+
+	for (auto iter = pmap.range({symbol, 0},{symbol, day*daysec}); iter.next();) {
+		std::uint64_t tm = iter.key(1).getUInt();
+		std::uint64_t d = tm/daysec;
+		if (d != curDay) {
+			if (!flush()) break;
+			curDay = d;
+		}
+		minutes.push_back({tm, iter.value().getNumber()});
+	}
+	flush();
+	commit();
+	if (blockCount) {
+		ondra_shared::logNote("Sealed $1 minutes of $2 into $3 blocks (before day $4)", minuteCount, std::string(symbol.getString()), blockCount, day);
+	}
+	return minuteCount;
+}
+
+void PriceStore::erase(Batch &batch, std::string_view symbol) {
+	for (auto iter = blocks.range({symbol, 0},{symbol, std::numeric_limits<std::uint64_t>::max()}); iter.next();) {
+		blocks.erase(batch, iter.key());
+	}
+	for (auto iter = rollup.range({symbol, 0},{symbol, std::numeric_limits<std::uint64_t>::max()}); iter.next();) {
+		rollup.erase(batch, iter.key());
+	}
+}
+
+void PriceStore::eraseBlock(Batch &batch, const json::Value &symbol, std::uint64_t day) {
+	if (mode == Mode::columnar) blocks.erase(batch, {symbol, day});
+}
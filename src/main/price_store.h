@@ -0,0 +1,194 @@
+/*
+ * price_store.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_PRICE_STORE_H_
+#define SRC_MAIN_PRICE_STORE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "../docdb/src/docdblib/db.h"
+#include "../docdb/src/docdblib/json_map.h"
+#include "candle.h"
+#include "gorilla.h"
+#include "group_commit.h"
+
+///Minute prices stored either as one key per minute or in compressed blocks
+/**
+ * Recent minutes are always stored in the minute map (key [symbol, time], value price).
+ * In the columnar mode, closed days are sealed: all minutes of the day are packed
+ * into one compressed block (key [symbol, day]) and removed from the minute map.
+ *
+ * The store provides the same range()/lookup() interface as the minute map and
+ * merges both sources transparently. If the minute map contains a minute which is
+ * also in a block (late import), the minute map wins
+ *
+ * With tiered retention, old minutes are replaced by candles of coarser timeframes
+ * (key [symbol, timeframe, frame], value [o,h,l,c]). The range() returns the candles
+ * before the minutes, as samples at the last minute of the frame with the close price
+ * (the close is not known before). A candle belongs to the range by its last minute
+ */
+class PriceStore {
+public:
+
+	enum class Mode {
+		///keep one key per minute
+		json,
+		///seal closed days into compressed blocks
+		columnar
+	};
+
+	PriceStore(docdb::DB &db, docdb::JsonMap &pmap, Mode mode);
+
+	class Iterator {
+	public:
+		Iterator(const PriceStore &owner, const json::Value &symbol, std::uint64_t from, std::uint64_t to, bool withRollup = true);
+
+		bool next();
+		std::uint64_t time() const {return curTime;}
+		double price() const {return curPrice;}
+
+		json::Value key() const {return {symbol, curTime};}
+		json::Value key(unsigned int index) const {return index?json::Value(curTime):symbol;}
+		///Price, or [o,h,l,c] for a rolled up candle
+		json::Value value() const {return candle.defined()?candle:json::Value(curPrice);}
+		///Item as a candle, all prices are equal for a minute
+		Candle ohlc() const {
+			if (!candle.defined()) return {curTime, curPrice, curPrice, curPrice, curPrice};
+			return {curTime, candle[0].getNumber(), candle[1].getNumber(), candle[2].getNumber(), curPrice};
+		}
+		///Count of minutes covered by the item (the timeframe of a rolled up candle)
+		std::uint64_t minutes() const {return candle.defined()?rollTf/60:1;}
+
+	protected:
+		json::Value symbol;
+		std::uint64_t from;
+		std::uint64_t to;
+		docdb::JsonMap::Iterator miter;
+		docdb::JsonMap::Iterator biter;
+		json::Value block;
+		GorillaDecoder decoder;
+
+		bool needM = true, needB = true;
+		bool hasM = false, hasB = false;
+		std::uint64_t tM = 0, tB = 0;
+		double vM = 0, vB = 0;
+
+		std::uint64_t curTime = 0;
+		double curPrice = 0;
+
+		const docdb::JsonMap *rollup = nullptr;
+		const std::vector<std::uint64_t> *timeframes = nullptr;
+		std::size_t tier = 0;
+		std::optional<docdb::JsonMap::Iterator> riter;
+		std::uint64_t rollTf = 0;
+		///end of the last candle, minutes before are hidden
+		std::uint64_t rollEnd = 0;
+		json::Value candle;
+
+		bool nextBlockItem();
+		bool nextRollup();
+		bool nextMinute();
+	};
+
+	///Enumerates range of prices
+	/**
+	 * @param from [symbol, time]
+	 * @param to [symbol, time] - not included
+	 * @return iterator
+	 */
+	Iterator range(const json::Value &from, const json::Value &to) const;
+	///Enumerates range of minute prices without rolled up candles
+	Iterator minuteRange(const json::Value &from, const json::Value &to) const;
+	///Lookups a price
+	/**
+	 * @param key [symbol, time]
+	 * @return price or undefined
+	 */
+	json::Value lookup(const json::Value &key) const;
+	///Finds the latest price at or before given time
+	/**
+	 * Costs one backward seek in the minute map and, in the columnar mode, decoding
+	 * of the blocks of the days within the tolerance
+	 *
+	 * @param symbol symbol
+	 * @param time time
+	 * @param tolerance max age of the price in seconds
+	 * @param foundTime receives time of the price
+	 * @param price receives the price
+	 * @retval true found
+	 * @retval false no price within the tolerance
+	 */
+	bool asOf(const json::Value &symbol, std::uint64_t time, std::uint64_t tolerance, std::uint64_t &foundTime, double &price) const;
+	///Returns end of the rolled up data of the symbol
+	/**
+	 * @param symbol symbol
+	 * @return end of the last candle, minutes before are hidden by the candles (0 - nothing rolled up)
+	 */
+	std::uint64_t rollupEnd(const json::Value &symbol) const;
+
+	bool columnar() const {return mode == Mode::columnar;}
+	///Some minutes are not in the minute map (views must read the store)
+	bool indirect() const {return columnar() || !timeframes.empty();}
+
+	///Enables rolled up candles
+	/**
+	 * @param timeframes timeframes of the tiers in seconds, from the finest
+	 */
+	void setRollup(std::vector<std::uint64_t> timeframes);
+
+	///Returns true once per day in the columnar mode (sealing should be started)
+	bool sealDue(std::uint64_t day);
+
+	///Seals closed days of the symbol before given day
+	/**
+	 * Does nothing in json mode. Minutes are erased from the minute map only when
+	 * they have not been changed since they were read (late import), such minutes
+	 * remain in the minute map and win over the block
+	 *
+	 * @param writer writer of the batches
+	 * @param symbol symbol
+	 * @param day current day (time/86400)
+	 * @param progress called after each sealed day with count of its minutes, returns
+	 * false to stop (can be empty)
+	 * @return count of sealed minutes
+	 */
+	std::size_t seal(GroupCommit &writer, const json::Value &symbol, std::uint64_t day,
+			const std::function<bool(std::size_t)> &progress = nullptr);
+
+	///Erases all blocks and candles of the symbol
+	void erase(docdb::Batch &batch, std::string_view symbol);
+	///Erases block of the day
+	void eraseBlock(docdb::Batch &batch, const json::Value &symbol, std::uint64_t day);
+
+	docdb::JsonMap &minutes() {return pmap;}
+	docdb::JsonMap &rollups() {return rollup;}
+
+	static constexpr std::uint64_t daysec = 24*60*60;
+
+protected:
+	docdb::DB &db;
+	docdb::JsonMap &pmap;
+	docdb::JsonMap blocks;
+	docdb::JsonMap rollup;
+	std::vector<std::uint64_t> timeframes;
+	Mode mode;
+	std::atomic<std::uint64_t> sealedDay = 0;
+
+	static GorillaDecoder decodeBlock(const json::Value &block);
+};
+
+inline std::uint64_t itemTime(PriceStore::Iterator &iter) {return iter.time();}
+inline double itemPrice(PriceStore::Iterator &iter) {return iter.price();}
+inline void itemValue(PriceStore::Iterator &iter, Candle &cd) {cd = iter.ohlc();}
+inline std::uint64_t itemMinutes(PriceStore::Iterator &iter) {return iter.minutes();}
+
+#endif /* SRC_MAIN_PRICE_STORE_H_ */
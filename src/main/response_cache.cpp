@@ -0,0 +1,297 @@
+/*
+ * response_cache.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "response_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+
+static std::string makeETag(std::string_view body) {
+	std::uint64_t h = 14695981039346656037ULL;
+	for (char c: body) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 1099511628211ULL;
+	}
+	char buff[40];
+	snprintf(buff, sizeof(buff), "\"%016llx\"", static_cast<unsigned long long>(h));
+	return buff;
+}
+
+ResponseCache::PEntry ResponseCache::find(const std::string &key) {
+	std::lock_guard _(lock);
+	auto iter = index.find(key);
+	if (iter == index.end()) {
+		misses++;
+		return nullptr;
+	}
+	hits++;
+	lru.splice(lru.begin(), lru, iter->second);
+	return iter->second->second;
+}
+
+std::uint64_t ResponseCache::generation() const {
+	std::lock_guard _(lock);
+	return curGeneration;
+}
+
+ResponseCache::PEntry ResponseCache::store(const std::string &key, std::string_view contentType, std::string &&body, std::vector<std::string> &&symbols, bool immutable, std::uint64_t generation) {
+	std::string etag = makeETag(body);
+	auto e = std::make_shared<Entry>(Entry{std::string(contentType), std::move(body), std::move(etag), std::move(symbols), immutable});
+	if (e->body.size() > maxEntrySize()) return e;
+
+	std::lock_guard _(lock);
+	if (cleared > generation) return e;
+	auto changedSince = [&](const Changes &c) {
+		return (immutable?c.historical:c.any) > generation;
+	};
+	for (const std::string &s: e->symbols) {
+		if (s == "*") {
+			if (changedSince(anyChanges)) return e;
+		} else {
+			auto iter = changes.find(s);
+			if (iter != changes.end() && changedSince(iter->second)) return e;
+		}
+	}
+	auto iter = index.find(key);
+	if (iter != index.end()) remove(iter->second);
+	lru.emplace_front(key, e);
+	index.emplace(key, lru.begin());
+	for (const std::string &s: e->symbols) bySymbol[s].insert(key);
+	curBytes += e->body.size() + key.size();
+	while (curBytes > maxBytes && !lru.empty()) {
+		remove(std::prev(lru.end()));
+	}
+	return e;
+}
+
+void ResponseCache::remove(LRUList::iterator iter) {
+	curBytes -= iter->second->body.size() + iter->first.size();
+	for (const std::string &s: iter->second->symbols) {
+		auto b = bySymbol.find(s);
+		if (b == bySymbol.end()) continue;
+		b->second.erase(iter->first);
+		if (b->second.empty()) bySymbol.erase(b);
+	}
+	index.erase(iter->first);
+	lru.erase(iter);
+}
+
+void ResponseCache::invalidate(const std::set<std::string, std::less<> > &symbols, bool includeImmutable) {
+	std::lock_guard _(lock);
+	++curGeneration;
+	auto mark = [&](Changes &c) {
+		c.any = curGeneration;
+		if (includeImmutable) c.historical = curGeneration;
+	};
+	mark(anyChanges);
+	std::vector<std::string> keys;
+	auto collect = [&](const std::string &symbol) {
+		auto b = bySymbol.find(symbol);
+		if (b != bySymbol.end()) keys.insert(keys.end(), b->second.begin(), b->second.end());
+	};
+	for (const std::string &s: symbols) {
+		mark(changes[s]);
+		collect(s);
+	}
+	collect("*");
+	for (const std::string &k: keys) {
+		auto iter = index.find(k);
+		//can be already removed (more symbols)
+		if (iter == index.end()) continue;
+		if (iter->second->second->immutable && !includeImmutable) continue;
+		remove(iter->second);
+	}
+}
+
+void ResponseCache::clear() {
+	std::lock_guard _(lock);
+	++curGeneration;
+	cleared = curGeneration;
+	lru.clear();
+	index.clear();
+	bySymbol.clear();
+	curBytes = 0;
+}
+
+ResponseCache::Stats ResponseCache::getStats() const {
+	std::lock_guard _(lock);
+	return Stats{hits, misses, curBytes, index.size()};
+}
+
+void ResponseCache::send(userver::PHttpServerRequest &req, const Entry &e) {
+	req->set("ETag", e.etag);
+	auto inm = req->get("If-None-Match");
+	if (inm.defined && inm.find(e.etag) != inm.npos) {
+		req->setStatus(304);
+		req->send("");
+	} else {
+		req->setContentType(e.contentType);
+		req->send(e.body);
+	}
+}
+
+void ResponseCapture::write(std::string_view data) {
+	bytes += data.size();
+	buffer.append(data);
+	if (!async) {
+		if (buffer.size() <= limit) return;
+		async = std::make_shared<AsyncState>();
+		async->owner = std::move(owner);
+		async->scheduler = std::move(scheduler);
+		req->setContentType(contentType);
+		async->stream.emplace(req->send());
+	}
+	if (buffer.size() >= chunkSize) sendBuffer();
+}
+
+void ResponseCapture::finish() {
+	if (!async) return;
+	if (!buffer.empty()) sendBuffer();
+	bool flush;
+	{
+		std::lock_guard _(async->lock);
+		async->finished = true;
+		flush = !async->writing && !async->failed;
+	}
+	if (flush) async->stream->flush();
+}
+
+void ResponseCapture::abort() {
+	if (!async) {
+		buffer.clear();
+		req->sendErrorPage(500);
+		return;
+	}
+	bool close;
+	{
+		std::lock_guard _(async->lock);
+		async->failed = true;
+		async->aborted = true;
+		//chunk being written must stay alive until the write completes
+		while (async->queue.size() > 1) async->queue.pop_back();
+		close = !async->writing;
+	}
+	if (close) async->stream->closeOutput();
+}
+
+bool ResponseCapture::full() const {
+	if (!async) return false;
+	std::lock_guard _(async->lock);
+	return async->queued >= maxQueued || async->failed;
+}
+
+bool ResponseCapture::suspend(std::function<void()> &&resume) {
+	if (!async) return false;
+	bool arm = false;
+	{
+		std::lock_guard _(async->lock);
+		if (async->failed) throw ResponseAborted();
+		if (async->queued < maxQueued) return false;
+		async->resume = std::move(resume);
+		async->suspended = async->progress = std::chrono::steady_clock::now();
+		if (async->scheduler && !async->watchdog) {
+			async->watchdog = true;
+			arm = true;
+		}
+	}
+	if (arm) {
+		std::weak_ptr<AsyncState> wk = async;
+		async->scheduler(writeTimeout, [wk]{checkTimeout(wk);});
+	}
+	return true;
+}
+
+std::chrono::nanoseconds ResponseCapture::getWriteTime() const {
+	if (!async) return {};
+	std::lock_guard _(async->lock);
+	return async->waited;
+}
+
+void ResponseCapture::sendBuffer() {
+	bool start;
+	{
+		std::lock_guard _(async->lock);
+		if (async->failed) throw ResponseAborted();
+		async->queued += buffer.size();
+		async->queue.push_back(std::move(buffer));
+		start = !async->writing;
+		async->writing = true;
+	}
+	buffer.clear();
+	buffer.reserve(chunkSize);
+	if (start) startWrite(async);
+}
+
+std::function<void()> ResponseCapture::takeResume(AsyncState &st) {
+	std::function<void()> r;
+	if (st.resume && (st.failed || st.queued < maxQueued)) {
+		r = std::move(st.resume);
+		st.resume = nullptr;
+		st.waited += std::chrono::steady_clock::now() - st.suspended;
+	}
+	return r;
+}
+
+void ResponseCapture::checkTimeout(const std::weak_ptr<AsyncState> &wk) {
+	auto st = wk.lock();
+	if (!st) return;
+	std::function<void()> r;
+	{
+		std::lock_guard _(st->lock);
+		if (!st->resume) {
+			//producer is running, next suspend schedules new check
+			st->watchdog = false;
+			return;
+		}
+		auto idle = std::chrono::steady_clock::now() - st->progress;
+		if (idle < writeTimeout) {
+			st->scheduler(writeTimeout - idle, [wk]{checkTimeout(wk);});
+			return;
+		}
+		st->watchdog = false;
+		st->failed = true;
+		//chunk being written must stay alive until the write completes
+		while (st->queue.size() > 1) st->queue.pop_back();
+		r = takeResume(*st);
+	}
+	r();
+}
+
+void ResponseCapture::startWrite(const PAsyncState &st) {
+	std::string_view data;
+	{
+		//the front chunk is not changed until its write completes
+		std::lock_guard _(st->lock);
+		data = st->queue.front();
+	}
+	st->stream->writeAsync(data, [st](bool ok) {
+		std::function<void()> resume;
+		bool next = false;
+		bool flush = false;
+		bool close = false;
+		{
+			std::lock_guard _(st->lock);
+			st->queued -= st->queue.front().size();
+			st->queue.pop_front();
+			st->progress = std::chrono::steady_clock::now();
+			if (!ok) st->failed = true;
+			if (st->failed || st->queue.empty()) {
+				st->queue.clear();
+				st->writing = false;
+				flush = st->finished && !st->failed;
+				close = st->aborted;
+			} else {
+				next = true;
+			}
+			resume = takeResume(*st);
+		}
+		if (next) startWrite(st);
+		if (flush) st->stream->flush();
+		if (close) st->stream->closeOutput();
+		if (resume) resume();
+	});
+}
@@ -0,0 +1,261 @@
+/*
+ * response_cache.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_RESPONSE_CACHE_H_
+#define SRC_MAIN_RESPONSE_CACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../userver/http_server.h"
+
+///LRU cache of complete responses
+/**
+ * Every entry remembers symbols from which it was generated. Immutable entries cover
+ * only closed days, so they are dropped only when historical data are changed (import, clean, purge).
+ * Other entries are also dropped when new prices of their symbols are committed.
+ * The symbol "*" means that entry depends on all symbols.
+ *
+ * Every invalidation advances the generation and records it for invalidated symbols.
+ * The generation is taken before the response is generated, store() refuses the
+ * response when its symbols have been invalidated since then (the response may
+ * contain old data).
+ */
+class ResponseCache {
+public:
+
+	struct Entry {
+		std::string contentType;
+		std::string body;
+		std::string etag;
+		std::vector<std::string> symbols;
+		bool immutable;
+	};
+
+	using PEntry = std::shared_ptr<const Entry>;
+
+	ResponseCache(std::size_t maxBytes):maxBytes(maxBytes) {}
+
+	///Finds entry
+	PEntry find(const std::string &key);
+	///Returns current generation, take it before the response is generated
+	std::uint64_t generation() const;
+	///Stores entry
+	/**
+	 * @param generation generation taken before the response has been generated
+	 * @return entry. Entry is also returned when it is too large to be stored, or when
+	 * its symbols have been invalidated after the generation (entry is not stored then)
+	 */
+	PEntry store(const std::string &key, std::string_view contentType, std::string &&body, std::vector<std::string> &&symbols, bool immutable, std::uint64_t generation);
+	///Drops entries depend on given symbols
+	/**
+	 * @param symbols changed symbols
+	 * @param includeImmutable drop also immutable entries (historical data has been changed)
+	 */
+	void invalidate(const std::set<std::string, std::less<> > &symbols, bool includeImmutable);
+	///Drops all entries
+	void clear();
+
+	///Sends entry as response. Handles If-None-Match
+	static void send(userver::PHttpServerRequest &req, const Entry &e);
+
+	///Largest response which can be stored
+	std::size_t maxEntrySize() const {return maxBytes/8;}
+
+	struct Stats {
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		std::size_t bytes = 0;
+		std::size_t entries = 0;
+	};
+	Stats getStats() const;
+
+protected:
+	using LRUList = std::list<std::pair<std::string, PEntry> >;
+
+	///generations of the last invalidations
+	struct Changes {
+		///any invalidation
+		std::uint64_t any = 0;
+		///invalidation of immutable entries
+		std::uint64_t historical = 0;
+	};
+
+	mutable std::mutex lock;
+	LRUList lru;
+	std::unordered_map<std::string, LRUList::iterator> index;
+	///keys of entries by symbols
+	std::unordered_map<std::string, std::unordered_set<std::string> > bySymbol;
+	std::unordered_map<std::string, Changes> changes;
+	///changes of any symbol (for entries depend on "*")
+	Changes anyChanges;
+	std::uint64_t curGeneration = 0;
+	///generation of the last clear()
+	std::uint64_t cleared = 0;
+	std::size_t maxBytes;
+	std::size_t curBytes = 0;
+	std::size_t hits = 0;
+	std::size_t misses = 0;
+
+	void remove(LRUList::iterator iter);
+};
+
+///Thrown by ResponseCapture, when the client doesn't accept data (connection closed or stalled)
+class ResponseAborted: public std::exception {
+public:
+	const char *what() const noexcept override {return "Response aborted: client is not receiving";}
+};
+
+///Collects response into buffer, which can be cached
+/**
+ * When response exceeds the limit, collected data are sent and the rest of
+ * the response is streamed directly, the response is not cached then.
+ *
+ * Streamed data are sent in chunks by asynchronous writes, one write is in progress
+ * at a time, write() never blocks. The producer should check full() and suspend itself
+ * by suspend(), which calls the resume function, when the socket accepts the queued data.
+ * When the client accepts nothing for writeTimeout while the producer is suspended, or the
+ * connection is closed, the response is aborted and write() throws ResponseAborted.
+ */
+class ResponseCapture {
+public:
+	///Size of a chunk of streamed response
+	static constexpr std::size_t chunkSize = 64*1024;
+	///Bytes waiting for the socket, when the producer should be suspended
+	static constexpr std::size_t maxQueued = 4*chunkSize;
+	///Max time without progress of the socket
+	static constexpr std::chrono::seconds writeTimeout{60};
+
+	///Schedules function after a delay (used to check the write timeout)
+	using Scheduler = std::function<void(std::chrono::steady_clock::duration, std::function<void()> &&)>;
+
+	///Construct capture
+	/**
+	 * @param req request
+	 * @param contentType content type
+	 * @param limit max size of captured response
+	 * @param owner optional object kept alive until all writes finish (owner of the request)
+	 * @param scheduler optional scheduler, without the scheduler the write timeout is not checked
+	 */
+	ResponseCapture(userver::PHttpServerRequest &req, std::string_view contentType, std::size_t limit,
+			std::shared_ptr<void> owner = nullptr, Scheduler scheduler = nullptr)
+		:req(req),contentType(contentType),limit(limit),owner(std::move(owner)),scheduler(std::move(scheduler)) {}
+
+	void write(std::string_view data);
+	void putChar(char c) {write(std::string_view(&c,1));}
+	void putCharNB(char c) {write(std::string_view(&c,1));}
+	///Sends remaining data, the stream is flushed when the last write completes
+	void finish();
+	///Aborts the response after an error of the producer
+	/**
+	 * When nothing has been sent yet, responds with the status 500. Otherwise the output
+	 * is closed (after the write in progress) without the end of the response, so the
+	 * client sees an incomplete response
+	 */
+	void abort();
+
+	///Returns true, when whole response has been captured
+	bool captured() const {return async == nullptr;}
+	///Returns true, when the producer should be suspended (enough data is waiting for the socket)
+	bool full() const;
+	///Suspends the producer until the socket accepts queued data
+	/**
+	 * @param resume function called (on a thread of the socket or of the scheduler) when
+	 * the queue is shorter than maxQueued, or when the response has been aborted
+	 * @retval true producer is suspended, resume will be called
+	 * @retval false queue is not full, resume is not called, producer can continue
+	 */
+	bool suspend(std::function<void()> &&resume);
+
+	std::string &body() {return buffer;}
+
+	///Formats one item of the response
+	/**
+	 * Every 64th call is timed, the time of formatting is estimated from these samples
+	 * @param fn function which formats the item
+	 */
+	template<typename Fn>
+	void format(Fn &&fn) {
+		if ((items++ & 63) == 0) {
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			formatSample += std::chrono::steady_clock::now() - start;
+		} else {
+			fn();
+		}
+	}
+
+	///Count of items passed through format()
+	std::uint64_t getItems() const {return items;}
+	///Total bytes of the response
+	std::uint64_t getBytes() const {return bytes;}
+	///Estimated time spent by formatting
+	std::chrono::nanoseconds getFormatTime() const {return formatSample * 64;}
+	///Time spent suspended waiting for the socket (when streamed)
+	std::chrono::nanoseconds getWriteTime() const;
+
+protected:
+	///State of the streamed response, shared with completion callbacks of the writes
+	struct AsyncState {
+		std::mutex lock;
+		std::optional<userver::Stream> stream;
+		std::shared_ptr<void> owner;
+		Scheduler scheduler;
+		///chunks, the first one is being written
+		std::deque<std::string> queue;
+		std::size_t queued = 0;
+		bool writing = false;
+		bool failed = false;
+		///all data queued, flush after the last write
+		bool finished = false;
+		///producer failed, close the output after the last write
+		bool aborted = false;
+		///timeout check is scheduled
+		bool watchdog = false;
+		///suspended producer
+		std::function<void()> resume;
+		std::chrono::steady_clock::time_point suspended;
+		///last completed write (or suspend)
+		std::chrono::steady_clock::time_point progress;
+		std::chrono::nanoseconds waited = {};
+	};
+	using PAsyncState = std::shared_ptr<AsyncState>;
+
+	userver::PHttpServerRequest &req;
+	std::string_view contentType;
+	std::size_t limit;
+	std::shared_ptr<void> owner;
+	Scheduler scheduler;
+	std::string buffer;
+	PAsyncState async;
+	std::uint64_t items = 0;
+	std::uint64_t bytes = 0;
+	std::chrono::nanoseconds formatSample = {};
+
+	///Queues the buffer for writing
+	void sendBuffer();
+	static void startWrite(const PAsyncState &st);
+	///Aborts the response, when the suspended producer waits too long
+	static void checkTimeout(const std::weak_ptr<AsyncState> &wk);
+	///Takes resume function, when the producer can continue (called under lock)
+	static std::function<void()> takeResume(AsyncState &st);
+};
+
+#endif /* SRC_MAIN_RESPONSE_CACHE_H_ */
@@ -0,0 +1,202 @@
+/*
+ * retention.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "retention.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include "candle.h"
+
+using namespace docdb;
+
+namespace {
+
+///Days committed in one batch
+constexpr std::size_t commitDays = 30;
+
+///Candles of one day
+class DayFolder {
+public:
+	DayFolder(std::uint64_t tf):tf(tf) {}
+	void add(std::uint64_t t, double o, double h, double l, double c) {
+		std::uint64_t f = t/tf*tf;
+		if (candles.empty() || candles.back().t != f) {
+			candles.push_back({f, o, h, l, c});
+		} else {
+			Candle &cd = candles.back();
+			cd.h = std::max(cd.h, h);
+			cd.l = std::min(cd.l, l);
+			cd.c = c;
+		}
+	}
+	///Marks frames of the views, where the candles are served (at the last minute of the frame)
+	void touch(Batch &batch, JsonMap &pmap, const json::Value &symbol) {
+		//erasing a missing key marks its frame dirty as well
+		for (const Candle &cd: candles) pmap.erase(batch, {symbol, cd.t + tf - 60});
+	}
+	void write(Batch &batch, JsonMap &rollup, const json::Value &symbol) {
+		for (const Candle &cd: candles) {
+			rollup.set(batch, {symbol, tf, cd.t/tf}, {cd.o, cd.h, cd.l, cd.c});
+		}
+		candles.clear();
+	}
+protected:
+	std::uint64_t tf;
+	std::vector<Candle> candles;
+};
+
+}
+
+std::vector<Retention::Tier> Retention::parseTiers(std::string_view spec) {
+	std::vector<Tier> out;
+	auto num = [&](std::string_view s) {
+		std::uint64_t v = 0;
+		auto r = std::from_chars(s.data(), s.data()+s.size(), v);
+		if (s.empty() || r.ec != std::errc() || r.ptr != s.data()+s.size()) {
+			throw std::invalid_argument("Invalid retention tier: "+std::string(spec));
+		}
+		return v;
+	};
+	while (!spec.empty()) {
+		auto sep = spec.find_first_of(", ");
+		auto item = spec.substr(0, sep);
+		spec = sep == spec.npos?std::string_view():spec.substr(sep+1);
+		if (item.empty()) continue;
+		auto colon = item.find(':');
+		if (colon == item.npos) throw std::invalid_argument("Invalid retention tier: "+std::string(item));
+		out.push_back({num(item.substr(0, colon)), num(item.substr(colon+1))});
+	}
+	return out;
+}
+
+void Retention::configure(std::uint64_t minuteDays, std::vector<Tier> tiers) {
+	if (minuteDays && tiers.empty()) throw std::invalid_argument("Retention needs at least one tier");
+	std::uint64_t prevTf = 1, prevDays = minuteDays;
+	for (std::size_t i = 0; i < tiers.size(); i++) {
+		const Tier &t = tiers[i];
+		if (t.timeframe <= prevTf || 1440 % t.timeframe || t.timeframe % prevTf) {
+			throw std::invalid_argument("Retention timeframes must divide the day and each other and must be increasing");
+		}
+		if (i+1 < tiers.size() && t.days <= prevDays) {
+			throw std::invalid_argument("Retention ages must be increasing, only the last tier can be kept forever");
+		}
+		prevTf = t.timeframe;
+		prevDays = t.days;
+	}
+	this->minuteDays = minuteDays;
+	this->tiers = std::move(tiers);
+	std::vector<std::uint64_t> timeframes;
+	if (minuteDays) {
+		for (const Tier &t: this->tiers) timeframes.push_back(t.timeframe*60);
+	}
+	store.setRollup(std::move(timeframes));
+}
+
+bool Retention::due(std::uint64_t day) {
+	if (!enabled()) return false;
+	std::uint64_t prev = lastDay;
+	return day > prev && lastDay.compare_exchange_strong(prev, day);
+}
+
+std::size_t Retention::run(JobContext &ctx, const std::string &symbol, std::uint64_t today) {
+	json::Value symb(symbol);
+	std::size_t days = rollMinutes(ctx, symb, today > minuteDays?(today - minuteDays)*daysec:0);
+	for (std::size_t i = 0; i+1 < tiers.size() && !ctx.cancelled(); i++) {
+		std::uint64_t age = tiers[i].days;
+		days += rollCandles(ctx, symb, tiers[i].timeframe*60, tiers[i+1].timeframe*60, today > age?(today - age)*daysec:0);
+	}
+	return days;
+}
+
+std::size_t Retention::rollMinutes(JobContext &ctx, const json::Value &symbol, std::uint64_t cut) {
+	if (!cut) return 0;
+	JsonMap &pmap = store.minutes();
+	JsonMap &rollup = store.rollups();
+	DayFolder folder(tiers[0].timeframe*60);
+	std::vector<std::uint64_t> times;
+	std::uint64_t day = 0;
+	std::size_t days = 0;
+	Batch batch;
+
+	auto flush = [&] {
+		if (times.empty()) return;
+		folder.touch(batch, pmap, symbol);
+		folder.write(batch, rollup, symbol);
+		//erasing minutes also marks the views dirty, they are recomputed from the candles
+		for (std::uint64_t t: times) pmap.erase(batch, {symbol, t});
+		store.eraseBlock(batch, symbol, day);
+		ctx.throttle(times.size());
+		times.clear();
+		if (++days % commitDays == 0) {
+			writer.commit(batch);
+			batch.Clear();
+		}
+	};
+
+	auto iter = store.minuteRange({symbol, 0},{symbol, cut});
+	while (iter.next()) {
+		std::uint64_t t = iter.time();
+		if (t/daysec != day) {
+			flush();
+			if (ctx.cancelled()) break;
+			day = t/daysec;
+		}
+		double p = iter.price();
+		folder.add(t, p, p, p, p);
+		times.push_back(t);
+	}
+	flush();
+	writer.commit(batch);
+	return days;
+}
+
+std::size_t Retention::rollCandles(JobContext &ctx, const json::Value &symbol, std::uint64_t src, std::uint64_t dst, std::uint64_t cut) {
+	if (!cut) return 0;
+	JsonMap &pmap = store.minutes();
+	JsonMap &rollup = store.rollups();
+	DayFolder folder(dst);
+	std::vector<json::Value> keys;
+	//minutes where the source candles are served
+	std::vector<std::uint64_t> served;
+	std::uint64_t day = 0;
+	std::size_t days = 0;
+	Batch batch;
+
+	auto flush = [&] {
+		if (keys.empty()) return;
+		//views drop the source candles and pick up the new ones (erasing a missing minute marks its frame dirty)
+		for (std::uint64_t t: served) pmap.erase(batch, {symbol, t});
+		folder.touch(batch, pmap, symbol);
+		for (const json::Value &k: keys) rollup.erase(batch, k);
+		folder.write(batch, rollup, symbol);
+		ctx.throttle(keys.size());
+		keys.clear();
+		served.clear();
+		if (++days % commitDays == 0) {
+			writer.commit(batch);
+			batch.Clear();
+		}
+	};
+
+	auto iter = rollup.range({symbol, src, 0},{symbol, src, cut/src});
+	while (iter.next()) {
+		std::uint64_t t = iter.key(2).getUInt()*src;
+		if (t/daysec != day) {
+			flush();
+			if (ctx.cancelled()) break;
+			day = t/daysec;
+		}
+		json::Value v = iter.value();
+		folder.add(t, v[0].getNumber(), v[1].getNumber(), v[2].getNumber(), v[3].getNumber());
+		keys.push_back(iter.key());
+		served.push_back(t + src - 60);
+	}
+	flush();
+	writer.commit(batch);
+	return days;
+}
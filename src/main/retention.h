@@ -0,0 +1,90 @@
+/*
+ * retention.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_RETENTION_H_
+#define SRC_MAIN_RETENTION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "group_commit.h"
+#include "jobs.h"
+#include "price_store.h"
+
+///Tiered retention of minute prices
+/**
+ * Minutes older than minuteDays are rolled up into candles of the first tier, candles
+ * older than the age of their tier are rolled up into the next tier. The last tier
+ * is kept forever. Candles are stored by the price store, which serves them in place
+ * of the removed minutes.
+ *
+ * Data are rolled up day by day, the new candles are written in the same batch
+ * which removes the source data, so readers never see a day twice or not at all.
+ * The batch also marks the frames of the views, where the old and the new data are
+ * served, so the views are recomputed. The 5m view then keeps one row per candle
+ * of the tier, the views are bounded by the policy as well.
+ */
+class Retention {
+public:
+
+	struct Tier {
+		///timeframe in minutes
+		std::uint64_t timeframe;
+		///max age in days, 0 = forever
+		std::uint64_t days;
+	};
+
+	Retention(PriceStore &store, GroupCommit &writer):store(store),writer(writer) {}
+
+	///Parses tiers
+	/**
+	 * @param spec list of <timeframe>:<days>, for example "5:1825 60:0"
+	 * @return tiers
+	 * @exception std::invalid_argument invalid format
+	 */
+	static std::vector<Tier> parseTiers(std::string_view spec);
+
+	///Sets the policy
+	/**
+	 * @param minuteDays max age of minutes in days, 0 = disabled
+	 * @param tiers tiers from the finest. Timeframes must divide the day and must
+	 * be increasing, so must be the ages
+	 * @exception std::invalid_argument invalid policy
+	 */
+	void configure(std::uint64_t minuteDays, std::vector<Tier> tiers);
+
+	bool enabled() const {return minuteDays != 0;}
+
+	///Returns true once per day, when the policy is enabled
+	bool due(std::uint64_t day);
+
+	///Rolls up old data of the symbol
+	/**
+	 * @param ctx context of the job
+	 * @param symbol symbol
+	 * @param today current day (time/86400)
+	 * @return count of rolled up days
+	 */
+	std::size_t run(JobContext &ctx, const std::string &symbol, std::uint64_t today);
+
+	static constexpr std::uint64_t daysec = PriceStore::daysec;
+
+protected:
+	PriceStore &store;
+	GroupCommit &writer;
+	std::uint64_t minuteDays = 0;
+	std::vector<Tier> tiers;
+	std::atomic<std::uint64_t> lastDay = 0;
+
+	std::size_t rollMinutes(JobContext &ctx, const json::Value &symbol, std::uint64_t cut);
+	std::size_t rollCandles(JobContext &ctx, const json::Value &symbol, std::uint64_t src, std::uint64_t dst, std::uint64_t cut);
+};
+
+#endif /* SRC_MAIN_RETENTION_H_ */
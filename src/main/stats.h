@@ -0,0 +1,120 @@
+/*
+ * stats.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_STATS_H_
+#define SRC_MAIN_STATS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+///Running mean and variance in one pass (Welford)
+class RunningMoments {
+public:
+	void add(double x) {
+		n++;
+		double d = x - m;
+		m += d/n;
+		m2 += d*(x - m);
+	}
+	std::uint64_t count() const {return n;}
+	double mean() const {return n?m:std::numeric_limits<double>::quiet_NaN();}
+	///Sample variance
+	double variance() const {return n > 1?m2/(n-1):std::numeric_limits<double>::quiet_NaN();}
+	double stddev() const {return std::sqrt(variance());}
+protected:
+	std::uint64_t n = 0;
+	double m = 0;
+	double m2 = 0;
+};
+
+///Mean and variance of last N values
+/**
+ * Values are kept in a ring buffer, the moments are updated by replacing the oldest
+ * value, so every step is O(1)
+ */
+class RollingMoments {
+public:
+	RollingMoments(std::size_t window):ring(std::max<std::size_t>(window, 1)) {}
+
+	void add(double x) {
+		if (n < ring.size()) {
+			ring[n++] = x;
+			double d = x - m;
+			m += d/n;
+			m2 += d*(x - m);
+		} else {
+			double x0 = ring[pos];
+			ring[pos] = x;
+			pos = (pos + 1) % ring.size();
+			double nm = m + (x - x0)/n;
+			m2 = std::max(0.0, m2 + (x - x0)*(x - nm + x0 - m));
+			m = nm;
+		}
+	}
+	///Window is full
+	bool full() const {return n == ring.size();}
+	double mean() const {return n?m:std::numeric_limits<double>::quiet_NaN();}
+	double variance() const {return n > 1?m2/(n-1):std::numeric_limits<double>::quiet_NaN();}
+	double stddev() const {return std::sqrt(variance());}
+protected:
+	std::vector<double> ring;
+	std::size_t n = 0;
+	std::size_t pos = 0;
+	double m = 0;
+	double m2 = 0;
+};
+
+///Running covariance and correlation of pairs in one pass
+class RunningCovariance {
+public:
+	void add(double x, double y) {
+		n++;
+		double dx = x - mx;
+		mx += dx/n;
+		double dy = y - my;
+		my += dy/n;
+		cxy += dx*(y - my);
+		vx += dx*(x - mx);
+		vy += dy*(y - my);
+	}
+	std::uint64_t count() const {return n;}
+	double covariance() const {return n > 1?cxy/(n-1):std::numeric_limits<double>::quiet_NaN();}
+	double correlation() const {
+		double d = std::sqrt(vx*vy);
+		return n > 1 && d > 0?cxy/d:std::numeric_limits<double>::quiet_NaN();
+	}
+protected:
+	std::uint64_t n = 0;
+	double mx = 0, my = 0;
+	double cxy = 0, vx = 0, vy = 0;
+};
+
+///Log returns of consecutive prices
+class LogReturns {
+public:
+	///Adds price
+	/**
+	 * @param v price
+	 * @param r receives log return from the previous price
+	 * @retval true return is available
+	 * @retval false first price or invalid price
+	 */
+	bool push(double v, double &r) {
+		bool ok = last > 0 && v > 0 && std::isfinite(v);
+		if (ok) r = std::log(v/last);
+		last = std::isfinite(v)?v:0;
+		return ok;
+	}
+	void reset() {last = 0;}
+protected:
+	double last = 0;
+};
+
+#endif /* SRC_MAIN_STATS_H_ */
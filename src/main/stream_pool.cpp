@@ -0,0 +1,119 @@
+/*
+ * stream_pool.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "stream_pool.h"
+
+#include <exception>
+#include "../shared/logOutput.h"
+#include "response_cache.h"
+
+StreamPool::~StreamPool() {
+	stop();
+}
+
+void StreamPool::start(unsigned int threads, std::size_t maxQueued) {
+	std::lock_guard _(lock);
+	this->maxQueued = maxQueued;
+	stopping = false;
+	for (unsigned int i = 0; i < std::max(threads, 1U); i++) {
+		workers.emplace_back([this]{worker();});
+	}
+}
+
+void StreamPool::stop() {
+	{
+		std::lock_guard _(lock);
+		stopping = true;
+	}
+	cond.notify_all();
+	for (auto &t: workers) t.join();
+	workers.clear();
+	//steps resumed after the threads have finished, released outside of the lock
+	std::deque<Task> q;
+	std::multimap<std::chrono::steady_clock::time_point, Task> tm;
+	{
+		std::lock_guard _(lock);
+		std::swap(q, queue);
+		std::swap(tm, timers);
+	}
+}
+
+bool StreamPool::run(Task &&task) {
+	{
+		std::lock_guard _(lock);
+		if (stopping || workers.empty() || queue.size() >= maxQueued) {
+			rejectedCnt++;
+			return false;
+		}
+		queue.push_back(std::move(task));
+	}
+	cond.notify_one();
+	return true;
+}
+
+bool StreamPool::resume(Task &&task) {
+	{
+		std::lock_guard _(lock);
+		if (workers.empty()) return false;
+		queue.push_back(std::move(task));
+	}
+	cond.notify_one();
+	return true;
+}
+
+void StreamPool::runAfter(std::chrono::steady_clock::duration delay, Task &&task) {
+	{
+		std::lock_guard _(lock);
+		if (stopping || workers.empty()) return;
+		timers.emplace(std::chrono::steady_clock::now() + delay, std::move(task));
+	}
+	cond.notify_one();
+}
+
+std::size_t StreamPool::queued() const {
+	std::lock_guard _(lock);
+	return queue.size();
+}
+
+void StreamPool::worker() {
+	std::unique_lock lk(lock);
+	for (;;) {
+		if (queue.empty() && !stopping) {
+			if (timers.empty()) cond.wait(lk);
+			else cond.wait_until(lk, timers.begin()->first);
+		}
+		//expired timers are moved to the queue
+		auto now = std::chrono::steady_clock::now();
+		while (!timers.empty() && timers.begin()->first <= now) {
+			queue.push_back(std::move(timers.begin()->second));
+			timers.erase(timers.begin());
+		}
+		if (queue.empty()) {
+			if (stopping) break;
+			continue;
+		}
+		Task t = std::move(queue.front());
+		queue.pop_front();
+		lk.unlock();
+		activeCnt++;
+		try {
+			t();
+		} catch (const ResponseAborted &) {
+			abortedCnt++;
+		} catch (const std::exception &e) {
+			abortedCnt++;
+			ondra_shared::logError("Stream task failed: $1", e.what());
+		} catch (...) {
+			//must not terminate the server
+			abortedCnt++;
+			ondra_shared::logError("Stream task failed: unknown exception");
+		}
+		activeCnt--;
+		t = nullptr;
+		lk.lock();
+	}
+}
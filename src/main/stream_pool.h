@@ -0,0 +1,90 @@
+/*
+ * stream_pool.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_STREAM_POOL_H_
+#define SRC_MAIN_STREAM_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///Threads generating large responses
+/**
+ * Handlers of data endpoints move the request to the pool, so threads of the HTTP
+ * server are released immediately and stay available for other requests. Count of
+ * waiting requests is limited, the server responds 503 when the pool is overloaded.
+ *
+ * Responses are generated in steps. A step ends when the socket has enough data waiting,
+ * the next step is queued by resume() from the completion of the write. So a slow client
+ * doesn't occupy a thread of the pool while the socket is full.
+ */
+class StreamPool {
+public:
+	using Task = std::function<void()>;
+
+	StreamPool() = default;
+	~StreamPool();
+
+	///Starts threads
+	/**
+	 * @param threads count of threads
+	 * @param maxQueued max count of waiting tasks
+	 */
+	void start(unsigned int threads, std::size_t maxQueued);
+	///Finishes waiting tasks and stops threads, steps resumed later are dropped
+	void stop();
+
+	///Runs task
+	/**
+	 * @retval true task queued
+	 * @retval false pool is not running or it is full
+	 */
+	bool run(Task &&task);
+	///Runs next step of an accepted task, it is not limited by the size of the queue
+	/**
+	 * @retval true task queued
+	 * @retval false pool is not running
+	 */
+	bool resume(Task &&task);
+	///Runs task after given delay
+	/**
+	 * Timers are not kept over stop(), pending timers are dropped
+	 */
+	void runAfter(std::chrono::steady_clock::duration delay, Task &&task);
+
+	///Count of running tasks (steps)
+	std::size_t active() const {return activeCnt;}
+	///Count of waiting tasks
+	std::size_t queued() const;
+	///Count of rejected tasks
+	std::uint64_t rejected() const {return rejectedCnt;}
+	///Count of tasks ended by an exception (usually the client stopped receiving)
+	std::uint64_t aborted() const {return abortedCnt;}
+
+protected:
+	mutable std::mutex lock;
+	std::condition_variable cond;
+	std::deque<Task> queue;
+	std::multimap<std::chrono::steady_clock::time_point, Task> timers;
+	std::vector<std::thread> workers;
+	std::size_t maxQueued = 0;
+	bool stopping = false;
+	std::atomic<std::size_t> activeCnt = 0;
+	std::atomic<std::uint64_t> rejectedCnt = 0;
+	std::atomic<std::uint64_t> abortedCnt = 0;
+
+	void worker();
+};
+
+#endif /* SRC_MAIN_STREAM_POOL_H_ */
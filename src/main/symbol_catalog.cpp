@@ -0,0 +1,91 @@
+/*
+ * symbol_catalog.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "symbol_catalog.h"
+
+#include <algorithm>
+#include <mutex>
+
+static constexpr std::uint64_t daysec = 24*60*60;
+
+void SymbolCatalog::set(std::string_view symbol, const Info &nfo) {
+	std::unique_lock _(lock);
+	auto iter = symbols.find(symbol);
+	if (iter == symbols.end()) {
+		symbols.emplace(std::string(symbol), nfo);
+	} else if (iter->second.firstDay != nfo.firstDay || iter->second.lastDay != nfo.lastDay || iter->second.days != nfo.days) {
+		iter->second = nfo;
+	} else {
+		return;
+	}
+	ver++;
+}
+
+void SymbolCatalog::erase(std::string_view symbol) {
+	std::unique_lock _(lock);
+	auto iter = symbols.find(symbol);
+	if (iter != symbols.end()) {
+		symbols.erase(iter);
+		ver++;
+	}
+	snapshots.clear();
+}
+
+void SymbolCatalog::commit(std::uint64_t time, Snapshot &&prices) {
+	std::uint64_t day = time/daysec;
+	auto snap = std::make_shared<const Snapshot>(std::move(prices));
+	std::unique_lock _(lock);
+	for (const auto &p: *snap) {
+		auto iter = symbols.find(p.first);
+		if (iter == symbols.end()) {
+			symbols.emplace(p.first, Info{day, day, 1});
+			ver++;
+		} else if (day > iter->second.lastDay) {
+			iter->second.lastDay = day;
+			iter->second.days++;
+			ver++;
+		}
+	}
+	//repeated commit of the same minute replaces snapshot
+	while (!snapshots.empty() && snapshots.back().first >= time) snapshots.pop_back();
+	snapshots.emplace_back(time, snap);
+	while (snapshots.size() > maxSnapshots) snapshots.pop_front();
+}
+
+SymbolCatalog::PSnapshot SymbolCatalog::snapshot(std::uint64_t time) const {
+	std::shared_lock _(lock);
+	for (const auto &s: snapshots) {
+		if (s.first == time) return s.second;
+	}
+	return nullptr;
+}
+
+void SymbolCatalog::clearSnapshots() {
+	std::unique_lock _(lock);
+	snapshots.clear();
+}
+
+std::uint64_t SymbolCatalog::firstTime(std::string_view asset, std::string_view currency) const {
+	std::shared_lock _(lock);
+	std::uint64_t res = 0;
+	for (std::string_view symbol: {asset, currency}) {
+		auto iter = symbols.find(symbol);
+		if (iter != symbols.end()) res = std::max(res, iter->second.firstDay*daysec);
+	}
+	return res;
+}
+
+std::vector<std::string> SymbolCatalog::activeIn(std::uint64_t from, std::uint64_t to) const {
+	std::uint64_t fromDay = from/daysec;
+	std::uint64_t toDay = to/daysec;
+	std::vector<std::string> out;
+	std::shared_lock _(lock);
+	for (const auto &x: symbols) {
+		if (x.second.firstDay <= toDay && x.second.lastDay >= fromDay) out.push_back(x.first);
+	}
+	return out;
+}
@@ -0,0 +1,98 @@
+/*
+ * symbol_catalog.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_SYMBOL_CATALOG_H_
+#define SRC_MAIN_SYMBOL_CATALOG_H_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///In-memory catalog of symbols and snapshots of recent minutes
+/**
+ * Catalog is loaded from the total range view at startup and updated by commits,
+ * so requests don't need to scan the view. It also keeps prices of all symbols
+ * of last few committed minutes, so recent history is served from memory.
+ */
+class SymbolCatalog {
+public:
+
+	struct Info {
+		///first day with data (time/86400)
+		std::uint64_t firstDay;
+		///last day with data
+		std::uint64_t lastDay;
+		///count of days with data
+		std::uint64_t days;
+	};
+
+	///Prices of one minute, ordered by symbol
+	using Snapshot = std::vector<std::pair<std::string, double> >;
+	using PSnapshot = std::shared_ptr<const Snapshot>;
+
+	///Construct catalog
+	/**
+	 * @param maxSnapshots count of recent minutes kept in memory
+	 */
+	SymbolCatalog(std::size_t maxSnapshots):maxSnapshots(maxSnapshots) {}
+
+	///Sets info about symbol
+	void set(std::string_view symbol, const Info &nfo);
+	///Removes symbol
+	void erase(std::string_view symbol);
+	///Records committed prices
+	/**
+	 * @param time time of the commit (whole minute)
+	 * @param prices committed prices, ordered by symbol
+	 */
+	void commit(std::uint64_t time, Snapshot &&prices);
+	///Retrieves snapshot of a minute
+	/**
+	 * @return snapshot or nullptr, if the minute is not in memory
+	 */
+	PSnapshot snapshot(std::uint64_t time) const;
+	///Drops all snapshots (historical data has been changed)
+	void clearSnapshots();
+	///Returns start of the first day, on which both symbols of the pair have data
+	/**
+	 * Unknown symbols (usd) are ignored. Returns 0, when neither symbol is known
+	 */
+	std::uint64_t firstTime(std::string_view asset, std::string_view currency) const;
+	///Returns symbols, which have data on the day of given time
+	std::vector<std::string> activeAt(std::uint64_t time) const {return activeIn(time, time);}
+	///Returns symbols, which have data on any day between given times (inclusive)
+	std::vector<std::string> activeIn(std::uint64_t from, std::uint64_t to) const;
+
+	///Returns version of the list of symbols, it changes when a symbol or its info is changed
+	std::uint64_t version() const {
+		std::shared_lock _(lock);
+		return ver;
+	}
+	///Enumerates symbols
+	/**
+	 * @param fn function(const std::string &symbol, const Info &nfo)
+	 */
+	template<typename Fn>
+	void forEach(Fn &&fn) const {
+		std::shared_lock _(lock);
+		for (const auto &x: symbols) fn(x.first, x.second);
+	}
+
+protected:
+	mutable std::shared_mutex lock;
+	std::map<std::string, Info, std::less<> > symbols;
+	std::deque<std::pair<std::uint64_t, PSnapshot> > snapshots;
+	std::size_t maxSnapshots;
+	std::uint64_t ver = 0;
+};
+
+#endif /* SRC_MAIN_SYMBOL_CATALOG_H_ */
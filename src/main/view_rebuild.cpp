@@ -0,0 +1,101 @@
+/*
+ * view_rebuild.cpp
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#include "view_rebuild.h"
+
+#include <imtjson/array.h>
+#include <imtjson/object.h>
+#include "../shared/logOutput.h"
+
+using namespace docdb;
+
+ViewRebuild::ViewRebuild(DB &db, JsonMap &meta, std::string name, unsigned int version, RebuildFn fn)
+	:db(db),meta(meta),name(std::move(name)),version(version),fn(std::move(fn)) {}
+
+std::size_t ViewRebuild::init(const std::vector<std::string> &symbols) {
+	std::lock_guard _(lock);
+	json::Value st = meta.lookup(name);
+	std::set<std::string, std::less<> > stored;
+	if (st["version"].getUInt() == version) {
+		if (st["complete"].getBool()) {
+			complete = true;
+			return 0;
+		}
+		for (json::Value s: st["done"]) stored.insert(s.getString());
+	}
+	done.clear();
+	todo.clear();
+	for (const auto &s: symbols) {
+		if (stored.count(s)) done.push_back(s);
+		else todo.insert(s);
+	}
+	total = symbols.size();
+	complete = todo.empty();
+	store();
+	if (!complete) {
+		ondra_shared::logNote("View $1 (version $2) needs rebuild: $3 of $4 symbols", name, version, todo.size(), total);
+	}
+	return todo.size();
+}
+
+std::vector<std::string> ViewRebuild::pending() const {
+	std::lock_guard _(lock);
+	return std::vector<std::string>(todo.begin(), todo.end());
+}
+
+void ViewRebuild::ensure(std::string_view symbol) {
+	if (complete) return;
+	rebuild(std::string(symbol), nullptr);
+}
+
+bool ViewRebuild::rebuild(const std::string &symbol, JobContext *ctx) {
+	std::unique_lock lk(lock);
+	//wait for other thread rebuilding the same symbol
+	while (building.count(symbol)) cond.wait(lk);
+	auto iter = todo.find(symbol);
+	if (iter == todo.end()) return true;
+	todo.erase(iter);
+	building.insert(symbol);
+	lk.unlock();
+	bool ok = false;
+	try {
+		ok = fn(symbol, ctx);
+	} catch (...) {
+		lk.lock();
+		building.erase(symbol);
+		todo.insert(symbol);
+		cond.notify_all();
+		throw;
+	}
+	lk.lock();
+	building.erase(symbol);
+	if (ok) {
+		done.push_back(symbol);
+		complete = todo.empty() && building.empty();
+		store();
+		if (complete) ondra_shared::logNote("View $1 rebuilt: $2 symbols", name, total);
+		else ondra_shared::logInfo("View $1 rebuild: $2/$3 symbols ($4)", name, done.size(), total, symbol);
+	} else {
+		todo.insert(symbol);
+	}
+	cond.notify_all();
+	return ok;
+}
+
+void ViewRebuild::store() {
+	json::Object st;
+	st.set("version", version);
+	st.set("complete", complete.load());
+	if (!complete) {
+		json::Array lst;
+		for (const auto &s: done) lst.push_back(s);
+		st.set("done", lst);
+	}
+	Batch b;
+	meta.set(b, name, st);
+	db.commitBatch(b);
+}
@@ -0,0 +1,97 @@
+/*
+ * view_rebuild.h
+ *
+ *  Created on: 17. 10. 2026
+ *      Author: ondra
+ */
+
+#ifndef SRC_MAIN_VIEW_REBUILD_H_
+#define SRC_MAIN_VIEW_REBUILD_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../docdb/src/docdblib/db.h"
+#include "../docdb/src/docdblib/json_map.h"
+#include "jobs.h"
+
+///Versioned checkpoint of a view derived from minute prices
+/**
+ * The checkpoint is stored in the meta map under the name of the view as
+ * {"version":..., "complete":..., "done":[symbols]}. When the stored version differs
+ * from the current version (format of the view changed, database created by
+ * an older version), the view is rebuilt symbol by symbol. A symbol can be
+ * rebuilt lazily on the first access (ensure()) or by a background job
+ * (rebuild()); rebuilt symbols are recorded, so the rebuild continues after restart.
+ */
+class ViewRebuild {
+public:
+
+	///Rebuilds one symbol
+	/**
+	 * function(const std::string &symbol, JobContext *ctx) - ctx is nullptr, when rebuild
+	 * is requested by a reader. Returns false, when it has been cancelled
+	 */
+	using RebuildFn = std::function<bool(const std::string &symbol, JobContext *ctx)>;
+
+	///Construct checkpoint
+	/**
+	 * @param db database
+	 * @param meta map of checkpoints
+	 * @param name name of the view
+	 * @param version current version of the view
+	 * @param fn rebuild function
+	 */
+	ViewRebuild(docdb::DB &db, docdb::JsonMap &meta, std::string name, unsigned int version, RebuildFn fn);
+
+	///Loads checkpoint and determines symbols to rebuild
+	/**
+	 * @param symbols all symbols in the database
+	 * @return count of symbols to rebuild
+	 */
+	std::size_t init(const std::vector<std::string> &symbols);
+
+	///Returns true, when the whole view is current
+	bool current() const {return complete;}
+	///Returns symbols, which are not rebuilt yet
+	std::vector<std::string> pending() const;
+
+	///Makes sure, that symbol is current, rebuilds it when needed
+	/**
+	 * Blocks, while the symbol is being rebuilt by other thread
+	 */
+	void ensure(std::string_view symbol);
+	///Rebuilds symbol (called by the background job for every pending symbol)
+	/**
+	 * @retval true symbol is current
+	 * @retval false cancelled
+	 */
+	bool rebuild(const std::string &symbol, JobContext *ctx);
+
+	const std::string &getName() const {return name;}
+
+protected:
+	docdb::DB &db;
+	docdb::JsonMap &meta;
+	std::string name;
+	unsigned int version;
+	RebuildFn fn;
+
+	mutable std::mutex lock;
+	std::condition_variable cond;
+	std::atomic<bool> complete = false;
+	std::set<std::string, std::less<> > todo;
+	std::set<std::string, std::less<> > building;
+	std::vector<std::string> done;
+	std::size_t total = 0;
+
+	void store();
+};
+
+#endif /* SRC_MAIN_VIEW_REBUILD_H_ */
@@ -108,7 +108,8 @@ async function updateChart(asset, currency, from, to) {
 			+"&currency="+encodeURIComponent(currency)
 			+"&from="+from_tm
 			+"&to="+to_tm
-			+"&timeframe="+frame).then(x=>x.json());
+			+"&timeframe="+frame
+			+"&points=1000").then(x=>x.json());
 	
 	if (data.length) {		
 		var opts =  stockChart.options;